@@ -0,0 +1,102 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frontier.hpp"
+
+namespace {
+struct BenchState {
+    int remaining;
+    double length;
+    int id;
+
+    bool operator<(const BenchState& other) const {
+        if (remaining != other.remaining)
+            return remaining < other.remaining;
+        if (length != other.length)
+            return length < other.length;
+        return id < other.id;
+    }
+
+    using Key = BenchState;
+
+    Key key() const { return *this; }
+};
+
+class GlobalQueue final {
+public:
+    GlobalQueue(unsigned, const size_t max_size) : max_size(max_size) {}
+
+    bool push(BenchState&& state) {
+        const std::scoped_lock lock(mutex);
+        if (states.size() >= max_size) {
+            const auto worst_it = std::prev(states.end());
+            if (!(state < *worst_it))
+                return false;
+            states.erase(worst_it);
+        }
+        return states.insert(std::move(state)).second;
+    }
+
+    std::optional<BenchState> try_pop() {
+        const std::scoped_lock lock(mutex);
+        if (states.empty())
+            return std::nullopt;
+        return states.extract(states.begin()).value();
+    }
+
+    void task_done() {}
+
+private:
+    const size_t max_size;
+    std::mutex mutex;
+    std::set<BenchState> states;
+};
+
+template <typename Queue>
+double run_workload(const unsigned num_threads, const int operations_per_thread, const size_t max_size) {
+    Queue queue(num_threads, max_size);
+    for (int i = 0; i < static_cast<int>(max_size / 2); ++i) {
+        queue.push({i % 64, static_cast<double>(i), i});
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            int next_id = static_cast<int>(max_size) + static_cast<int>(t) * operations_per_thread * 2;
+            for (int i = 0; i < operations_per_thread; ++i) {
+                auto state = queue.try_pop();
+                if (!state)
+                    continue;
+                queue.push({std::max(state->remaining - 1, 0), state->length + 1.5, next_id++});
+                queue.push({state->remaining, state->length + 3.0, next_id++});
+                queue.task_done();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return num_threads * static_cast<double>(operations_per_thread) / seconds;
+}
+} // namespace
+
+int main(const int argc, char** argv) {
+    const unsigned max_threads = argc > 1 ? std::stoi(argv[1]) : 64;
+    const int operations_per_thread = argc > 2 ? std::stoi(argv[2]) : 20000;
+    const size_t max_size = argc > 3 ? std::stoul(argv[3]) : 100000;
+    std::cout << "threads,global_mutex_pops_per_sec,frontier_pops_per_sec\n";
+    for (unsigned num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        const double global = run_workload<GlobalQueue>(num_threads, operations_per_thread, max_size);
+        const double sharded = run_workload<Frontier<BenchState>>(num_threads, operations_per_thread, max_size);
+        std::cout << num_threads << ',' << static_cast<long long>(global) << ',' << static_cast<long long>(sharded)
+                  << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "parser.hpp"
+
+namespace {
+void write_map(const std::string& file_path, const int vertex_count, const int edge_count, const int quest_count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> vertex_dist(0, vertex_count - 1);
+    std::uniform_real_distribution<double> weight_dist(0.0, 100.0);
+    std::ofstream out(file_path);
+    out << "FastTravel:\n\tFalse\nBidirectional:\n\tTrue\nWeighted:\n\tTrue\nVertexCount:\n\t" << vertex_count
+        << "\nEdges:\n";
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    for (int i = 0; i < edge_count; ++i) {
+        out << '\t' << vertex_dist(rng) << ' ' << vertex_dist(rng) << ' ' << weight_dist(rng) << '\n';
+    }
+    out << "QuestLines:\n";
+    for (int i = 0; i < quest_count; ++i) {
+        out << '\t' << vertex_dist(rng) << ' ' << vertex_dist(rng) << ' ' << vertex_dist(rng) << '\n';
+    }
+}
+
+template <typename Parse>
+double measure_mb_per_second(const std::string& file_path, Parse&& parse, int& edge_count) {
+    const auto begin = std::chrono::steady_clock::now();
+    const GraphData graph_data = parse(file_path);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    edge_count = graph_data.graph.edge_count();
+    return static_cast<double>(std::filesystem::file_size(file_path)) / (1 << 20) / seconds;
+}
+} // namespace
+
+int main(const int argc, char** argv) {
+    const int vertex_count = argc > 1 ? std::stoi(argv[1]) : 200000;
+    const int edge_count = argc > 2 ? std::stoi(argv[2]) : 2000000;
+    const std::string file_path =
+        (std::filesystem::temp_directory_path() / "quest_optimizer_x_parser_benchmark.txt").string();
+    write_map(file_path, vertex_count, edge_count, 100);
+
+    int sequential_edges = 0;
+    int parallel_edges = 0;
+    const double sequential = measure_mb_per_second(
+        file_path, [](const std::string& path) { return Parser(1).parse(path); }, sequential_edges
+    );
+    const double parallel = measure_mb_per_second(file_path, Parser::parse_file, parallel_edges);
+    std::filesystem::remove(file_path);
+
+    const bool edges_match = sequential_edges == parallel_edges;
+    std::cout << "file: " << vertex_count << " vertices, " << edge_count << " edge lines\n"
+              << "1 thread:  " << sequential << " MB/s\n"
+              << std::thread::hardware_concurrency() << " threads: " << parallel << " MB/s\n"
+              << "csr edges " << (edges_match ? "match" : "DIFFER") << '\n';
+    return edges_match ? 0 : 1;
+}
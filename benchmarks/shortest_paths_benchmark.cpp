@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+
+#include "shortest_paths.hpp"
+
+namespace {
+GraphData make_random_graph(const int vertex_count, const int out_degree, const unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> vertex_dist(0, vertex_count - 1);
+    std::uniform_real_distribution<double> weight_dist(1.0, 100.0);
+    GraphData graph_data{};
+    graph_data.vertex_count = vertex_count;
+    graph_data.weighted = true;
+    std::vector<std::vector<Edge>> adj_list(vertex_count);
+    for (int from = 0; from < vertex_count; ++from) {
+        adj_list[from].push_back({(from + 1) % vertex_count, weight_dist(rng)});
+        for (int i = 1; i < out_degree; ++i) {
+            adj_list[from].push_back({vertex_dist(rng), weight_dist(rng)});
+        }
+        std::ranges::sort(adj_list[from], {}, &Edge::to);
+    }
+    graph_data.graph = CsrGraph::from_adjacency(adj_list);
+    return graph_data;
+}
+
+std::vector<double> reference_dijkstra(const GraphData& graph_data, const int source) {
+    std::vector dist(graph_data.vertex_count, ShortestPaths::infinity);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> pq;
+    dist[source] = 0.0;
+    pq.emplace(0.0, source);
+    while (!pq.empty()) {
+        const auto [length, current] = pq.top();
+        pq.pop();
+        if (length > dist[current])
+            continue;
+        const auto& graph = graph_data.graph;
+        for (int edge = graph.edge_begin(current); edge < graph.edge_end(current); ++edge) {
+            if (const double next_length = length + graph.weights[edge]; next_length < dist[graph.targets[edge]]) {
+                dist[graph.targets[edge]] = next_length;
+                pq.emplace(next_length, graph.targets[edge]);
+            }
+        }
+    }
+    return dist;
+}
+
+template <typename Func>
+double measure_ms(Func&& func) {
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+} // namespace
+
+int main(const int argc, char** argv) {
+    const int vertex_count = argc > 1 ? std::stoi(argv[1]) : 200000;
+    const int out_degree = argc > 2 ? std::stoi(argv[2]) : 4;
+    const int query_count = argc > 3 ? std::stoi(argv[3]) : 20;
+    const auto graph_data = make_random_graph(vertex_count, out_degree, 42);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> vertex_dist(0, vertex_count - 1);
+    std::vector<int> sources(query_count);
+    for (auto& source : sources) {
+        source = vertex_dist(rng);
+    }
+
+    double checksum_reference = 0.0;
+    const double reference_ms = measure_ms([&] {
+        for (const int source : sources) {
+            checksum_reference += reference_dijkstra(graph_data, source)[sources.front()];
+        }
+    });
+
+    double checksum_engine = 0.0;
+    ShortestPaths engine(graph_data);
+    const double engine_ms = measure_ms([&] {
+        for (const int source : sources) {
+            engine.run(source);
+            checksum_engine += engine.distance(sources.front());
+        }
+    });
+
+    std::cout << "vertices: " << vertex_count << " edges: " << static_cast<long long>(vertex_count) * out_degree
+              << " queries: " << query_count << '\n'
+              << "reference priority_queue: " << reference_ms / query_count << " ms/query\n"
+              << "ShortestPaths d-ary heap: " << engine_ms / query_count << " ms/query\n"
+              << "checksums " << (checksum_reference == checksum_engine ? "match" : "DIFFER") << '\n';
+    return checksum_reference == checksum_engine ? 0 : 1;
+}
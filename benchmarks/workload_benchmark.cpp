@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "distance_oracle.hpp"
+#include "fast_travel_solver.hpp"
+#include "mapped_parser.hpp"
+#include "memory_usage.hpp"
+#include "quest_optimizer_x.hpp"
+
+namespace {
+struct Workload {
+    std::string shape;
+    int vertex_count;
+    int quest_line_count;
+};
+
+// Map shapes: "grid" is a weighted lattice, "random" a random tree plus as many random edges, and "hub" a ring of
+// hubs with corridors of non-quest vertices hanging off them. "fast_travel" is a "random" map with fast travel on,
+// which is solved by the FastTravelSolver instead of the queue search.
+const std::map<std::string, std::vector<Workload>> scale_classes = {
+    {"small",
+     {{"grid", 1000, 10},
+      {"random", 1000, 10},
+      {"hub", 1000, 10},
+      {"fast_travel", 1000, 10},
+      {"grid", 1000, 100},
+      {"random", 1000, 100},
+      {"hub", 1000, 100},
+      {"fast_travel", 1000, 100}}},
+    {"medium",
+     {{"grid", 100000, 10},
+      {"random", 100000, 10},
+      {"hub", 100000, 10},
+      {"fast_travel", 100000, 10},
+      {"grid", 10000, 100},
+      {"random", 10000, 100},
+      {"hub", 10000, 100},
+      {"fast_travel", 10000, 100},
+      {"random", 1000, 500},
+      {"fast_travel", 1000, 500}}},
+    {"large",
+     {{"grid", 1000000, 10},
+      {"random", 1000000, 10},
+      {"hub", 1000000, 10},
+      {"fast_travel", 1000000, 10},
+      {"grid", 100000, 100},
+      {"random", 100000, 100},
+      {"hub", 100000, 100},
+      {"fast_travel", 100000, 100},
+      {"grid", 10000, 500},
+      {"random", 10000, 500},
+      {"hub", 10000, 500},
+      {"fast_travel", 10000, 500}}},
+};
+
+constexpr int hub_corridor_length = 10;
+constexpr int min_quest_line_length = 2;
+constexpr int max_quest_line_length = 8;
+
+class NullBuffer final : public std::streambuf {
+protected:
+    int overflow(const int c) override { return c; }
+
+    std::streamsize xsputn(const char*, const std::streamsize count) override { return count; }
+};
+
+void write_map(const std::string& file_path, const Workload& workload, const std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const int n = workload.vertex_count;
+    std::uniform_int_distribution<int> vertex_dist(0, n - 1);
+    std::uniform_real_distribution<double> weight_dist(1.0, 10.0);
+    const bool fast_travel = workload.shape == "fast_travel";
+    std::ofstream out(file_path);
+    out << "FastTravel:\n\t" << (fast_travel ? "True" : "False")
+        << "\nBidirectional:\n\tTrue\nWeighted:\n\tTrue\nVertexCount:\n\t" << n << "\nEdges:\n";
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    const auto edge = [&](const int from, const int to) {
+        out << '\t' << from << ' ' << to << ' ' << weight_dist(rng) << '\n';
+    };
+    if (workload.shape == "grid") {
+        const int side = std::max(static_cast<int>(std::sqrt(n)), 1);
+        for (int v = 0; v < n; ++v) {
+            if ((v + 1) % side != 0 && v + 1 < n)
+                edge(v, v + 1);
+            if (v + side < n)
+                edge(v, v + side);
+        }
+    } else if (workload.shape == "random" || fast_travel) {
+        for (int v = 1; v < n; ++v) {
+            edge(std::uniform_int_distribution<int>(0, v - 1)(rng), v);
+        }
+        for (int i = 0; i < n; ++i) {
+            edge(vertex_dist(rng), vertex_dist(rng));
+        }
+    } else if (workload.shape == "hub") {
+        const int hubs = std::clamp(n / 100, 2, n);
+        std::uniform_int_distribution<int> hub_dist(0, hubs - 1);
+        for (int hub = 0; hub < hubs; ++hub) {
+            edge(hub, (hub + 1) % hubs);
+            edge(hub, hub_dist(rng));
+        }
+        for (int v = hubs; v < n; ++v) {
+            edge((v - hubs) % hub_corridor_length == 0 ? hub_dist(rng) : v - 1, v);
+        }
+    } else {
+        throw std::invalid_argument("Unknown map shape " + workload.shape);
+    }
+    out << "QuestLines:\n";
+    std::uniform_int_distribution<int> length_dist(min_quest_line_length, max_quest_line_length);
+    for (int i = 0; i < workload.quest_line_count; ++i) {
+        out << '\t';
+        for (int stop = length_dist(rng); stop > 0; --stop) {
+            out << vertex_dist(rng) << (stop > 1 ? " " : "\n");
+        }
+    }
+}
+
+double milliseconds(const std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::string json_number(const double value) {
+    if (!std::isfinite(value))
+        return "null";
+    std::ostringstream out;
+    out.precision(10);
+    out << value;
+    return out.str();
+}
+
+// Distinct quest stops plus the start vertex, the same set a DistanceOracle is built over.
+size_t stop_count(const GraphData& graph_data) {
+    auto stops = DistanceOracle::quest_stops(graph_data);
+    std::ranges::sort(stops);
+    return static_cast<size_t>(std::ranges::distance(stops.begin(), std::ranges::unique(stops).begin()));
+}
+
+// Longest walk of a single quest line: no route can be shorter. With fast travel (`oracle` is nullptr) every move
+// costs 1, and every stop after the first needs a move of its own.
+double lower_bound(const GraphData& graph_data, const DistanceOracle* oracle) {
+    double bound = oracle != nullptr ? 0.0 : static_cast<double>(std::max<size_t>(stop_count(graph_data), 1) - 1);
+    for (const auto& quest_line : graph_data.quest_lines) {
+        double length = 0.0;
+        for (size_t i = 1; i < quest_line.vertexes.size(); ++i) {
+            length += oracle != nullptr ? oracle->distance(quest_line.vertexes[i - 1], quest_line.vertexes[i]) : 1.0;
+        }
+        bound = std::max(bound, length);
+    }
+    return bound;
+}
+
+std::string run_workload(
+    const Workload& workload,
+    const std::uint64_t seed,
+    const unsigned num_threads,
+    const unsigned max_queue_size,
+    const unsigned beam_width,
+    const SearchLimits& limits
+) {
+    const std::string file_path =
+        (std::filesystem::temp_directory_path() / "quest_optimizer_x_workload_benchmark.txt").string();
+    write_map(file_path, workload, seed);
+    std::ostringstream result;
+    result << "{\"shape\":\"" << workload.shape << "\",\"vertices\":" << workload.vertex_count
+           << ",\"quest_lines\":" << workload.quest_line_count << ",\"seed\":" << seed;
+    try {
+        reset_peak_resident_set();
+        const auto parse_begin = std::chrono::steady_clock::now();
+        const GraphData graph_data = MappedParser::parse_file(file_path, num_threads);
+        const auto preprocess_begin = std::chrono::steady_clock::now();
+        // fast travel moves all cost 1, so only walking maps need the stop distances
+        std::shared_ptr<const DistanceOracle> oracle;
+        if (!graph_data.fast_travel)
+            oracle = std::make_shared<const DistanceOracle>(graph_data, num_threads);
+        const auto solve_begin = std::chrono::steady_clock::now();
+        std::optional<QuestOptimizer> optimizer;
+        std::optional<FastTravelSolver> fast_travel_solver;
+        if (graph_data.fast_travel) {
+            fast_travel_solver.emplace(graph_data, num_threads, beam_width);
+            fast_travel_solver->set_limits(limits);
+            fast_travel_solver->optimize();
+        } else {
+            optimizer.emplace(graph_data, num_threads, max_queue_size, 1.05, 1, 0.0, oracle);
+            optimizer->set_limits(limits);
+            optimizer->optimize();
+        }
+        const auto output_begin = std::chrono::steady_clock::now();
+        const Path path = optimizer ? optimizer->get_best_path() : fast_travel_solver->get_best_path();
+        print_quests_on_path(
+            path,
+            graph_data.quest_lines,
+            graph_data.stop_index,
+            graph_data.vertex_names,
+            false,
+            false
+        );
+        const auto end = std::chrono::steady_clock::now();
+
+        const double solve_seconds = std::chrono::duration<double>(output_begin - solve_begin).count();
+        const double bound = lower_bound(graph_data, oracle.get());
+        const bool proven_optimal =
+            optimizer ? optimizer->is_proven_optimal() : fast_travel_solver->is_proven_optimal();
+        result << ",\"edges\":" << graph_data.graph.edge_count()
+               << ",\"stops\":" << stop_count(graph_data)
+               << ",\"parse_ms\":" << json_number(milliseconds(preprocess_begin - parse_begin))
+               << ",\"preprocess_ms\":" << json_number(milliseconds(solve_begin - preprocess_begin))
+               << ",\"solve_ms\":" << json_number(milliseconds(output_begin - solve_begin))
+               << ",\"output_ms\":" << json_number(milliseconds(end - output_begin));
+        // the fast travel beam search keeps no queue counters
+        if (optimizer) {
+            const auto counters = optimizer->metrics().totals();
+            result << ",\"expansions\":" << optimizer->expanded_states() << ",\"expansions_per_sec\":"
+                   << json_number(static_cast<double>(optimizer->expanded_states()) / solve_seconds)
+                   << ",\"lock_wait_ms\":" << json_number(counters[WorkerMetrics::lock_wait_ns] / 1e6)
+                   << ",\"idle_ms\":" << json_number(counters[WorkerMetrics::idle_ns] / 1e6)
+                   << ",\"evictions\":" << counters[WorkerMetrics::evictions];
+        }
+        result << ",\"peak_rss_bytes\":" << peak_resident_set_bytes() << ",\"length\":" << json_number(path.length)
+               << ",\"lower_bound\":" << json_number(bound)
+               << ",\"gap\":" << json_number(bound > 0.0 ? path.length / bound - 1.0 : 0.0)
+               << ",\"proven_optimal\":" << (proven_optimal ? "true" : "false");
+    } catch (const std::exception& e) {
+        result << ",\"error\":\"" << e.what() << '"';
+    }
+    std::filesystem::remove(file_path);
+    result << '}';
+    return result.str();
+}
+} // namespace
+
+// Usage: workload_benchmark [--scale small|medium|large] [--seed N] [--num_threads N] [--max_queue_size N]
+//                           [--beam_width N] [--time_limit_ms N] [--output file.json]
+// Times parse, preprocessing, solve and output on seeded synthetic maps and reports one JSON document, so runs of
+// two versions with the same seed can be compared case by case.
+int main(const int argc, char** argv) {
+    std::map<std::string, std::string> args{
+        {"--scale", "small"},
+        {"--seed", "1"},
+        {"--num_threads", std::to_string(std::max(std::thread::hardware_concurrency(), 1u))},
+        {"--max_queue_size", "10000"},
+        {"--beam_width", std::to_string(FastTravelSolver::default_beam_width)},
+        {"--time_limit_ms", "10000"},
+    };
+    for (int i = 1; i + 1 < argc; i += 2) {
+        args[argv[i]] = argv[i + 1];
+    }
+    const auto scale = scale_classes.find(args["--scale"]);
+    if (scale == scale_classes.end()) {
+        std::cerr << "Unknown scale " << args["--scale"] << ", use small, medium or large\n";
+        return 1;
+    }
+    const std::uint64_t seed = std::stoull(args["--seed"]);
+    const unsigned num_threads = std::stoi(args["--num_threads"]);
+    const SearchLimits limits{.time_budget = std::chrono::milliseconds(std::stoll(args["--time_limit_ms"]))};
+
+    // solver progress logs and the printed routes are part of the measurement but not of the report
+    std::ofstream output_file;
+    if (args.contains("--output"))
+        output_file.open(args["--output"]);
+    std::ostream report(args.contains("--output") ? output_file.rdbuf() : std::cout.rdbuf());
+    NullBuffer null_buffer;
+    std::cout.rdbuf(&null_buffer);
+
+    report << "{\"scale\":\"" << scale->first << "\",\"seed\":" << seed << ",\"num_threads\":" << num_threads
+           << ",\"max_queue_size\":" << args["--max_queue_size"] << ",\"beam_width\":" << args["--beam_width"]
+           << ",\"time_limit_ms\":" << args["--time_limit_ms"] << ",\"cases\":[";
+    for (size_t i = 0; i < scale->second.size(); ++i) {
+        std::cerr << "Running " << scale->second[i].shape << ' ' << scale->second[i].vertex_count << " vertices, "
+                  << scale->second[i].quest_line_count << " quest lines" << std::endl;
+        report << (i > 0 ? ",\n" : "\n")
+               << run_workload(
+                      scale->second[i],
+                      seed + i,
+                      num_threads,
+                      std::stoi(args["--max_queue_size"]),
+                      std::stoi(args["--beam_width"]),
+                      limits
+                  );
+    }
+    report << "\n]}" << std::endl;
+    std::cout.rdbuf(report.rdbuf());
+    return 0;
+}
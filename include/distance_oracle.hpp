@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cassert>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "parser.hpp"
+#include "shortest_paths.hpp"
+
+class DistanceOracle final {
+public:
+    static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+    explicit DistanceOracle(const GraphData& graph_data, unsigned num_threads = std::thread::hardware_concurrency());
+
+    // Oracle over an explicit set of stop vertices, e.g. the quest stops of a whole map plus one query start.
+    DistanceOracle(const GraphData& graph_data, std::vector<int> stops, unsigned num_threads);
+
+    // Quest stops of `graph_data` plus its start vertex, if any.
+    static std::vector<int> quest_stops(const GraphData& graph_data);
+
+    const std::vector<int>& stops() const { return stop_vertexes; }
+
+    int stop_count() const { return static_cast<int>(stop_vertexes.size()); }
+
+    // Index of `vertex` among the stops, or -1 if it is not a stop.
+    int stop_index(const int vertex) const { return vertex_to_stop[vertex]; }
+
+    double distance_between_stops(const int from_stop, const int to_stop) const {
+        return distances[static_cast<size_t>(from_stop) * stop_vertexes.size() + to_stop];
+    }
+
+    // Distances from one stop to every stop, indexed by stop index.
+    const double* distances_from_stop(const int from_stop) const {
+        return distances.data() + static_cast<size_t>(from_stop) * stop_vertexes.size();
+    }
+
+    // Both vertices must be stops of this oracle; distances from any other vertex need a ShortestPaths search.
+    double distance(const int from_vertex, const int to_vertex) const {
+        assert(vertex_to_stop[from_vertex] != -1 && vertex_to_stop[to_vertex] != -1);
+        return distance_between_stops(vertex_to_stop[from_vertex], vertex_to_stop[to_vertex]);
+    }
+
+    // Turns a sequence of quest stops into the full vertex route walked between them.
+    std::vector<int> expand(const std::vector<int>& stop_route) const;
+
+private:
+    const GraphData& graph_data;
+    std::vector<int> stop_vertexes;
+    std::vector<int> vertex_to_stop;
+    std::vector<double> distances;
+
+    void fill_row(int from_stop, ShortestPaths& engine);
+
+    // Vertices strictly after `from_vertex` up to and including `to_vertex` on a shortest route.
+    static std::vector<int> unpack(ShortestPaths& engine, int from_vertex, int to_vertex);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "distance_oracle.hpp"
+#include "parser.hpp"
+#include "path_store.hpp"
+#include "quest_optimizer_x.hpp"
+
+// Exact dynamic programming over (quest progress tuple, last visited quest stop), Held-Karp style. Progress tuples
+// are indexed in mixed radix and processed in layers of completed stop count, each layer in parallel. The table
+// is dense, so the solver refuses instances whose table would exceed `max_table_bytes`.
+class ExactSolver final {
+public:
+    static constexpr size_t default_max_table_bytes = size_t{1} << 30;
+
+    // `oracle` gives walking distances between quest stops and is required on walking maps. Fast travel moves all
+    // cost 1, so it is not read there and may be nullptr.
+    ExactSolver(
+        const GraphData& graph_data,
+        const DistanceOracle* oracle,
+        unsigned num_threads = std::thread::hardware_concurrency(),
+        size_t max_table_bytes = default_max_table_bytes
+    );
+
+    // The DP has no partial answer, so solve() throws once the time budget runs out or the process grows beyond
+    // `max_rss_bytes`. The memory budget also caps the table size.
+    void set_limits(const SearchLimits& limits) { this->limits = limits; }
+
+    // Certified-optimal route that starts at `start_vertex` (any vertex when -1) with quest lines already advanced
+    // to `initial_positions`. Returns a path with infinite length if the remaining stops cannot all be reached.
+    Path solve(int start_vertex, const std::vector<size_t>& initial_positions) const;
+
+    Path solve() const;
+
+    // Table size in bytes needed to solve from `initial_positions`, or SIZE_MAX if it does not fit in size_t.
+    size_t table_bytes(const std::vector<size_t>& initial_positions) const;
+
+private:
+    const GraphData& graph_data;
+    const DistanceOracle* oracle;
+    const unsigned num_threads;
+    const size_t max_table_bytes;
+    SearchLimits limits;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parser.hpp"
+#include "path_store.hpp"
+#include "quest_optimizer_x.hpp"
+
+// Direct solver for fast travel maps. Every move costs 1, so a route is a shortest common supersequence of the quest
+// lines: visiting a vertex advances every quest line waiting on it. The solver runs a beam search over quest progress
+// with one layer per visited stop; progress reached twice in a layer is merged, and each layer keeps the
+// `beam_width` states with the best lower bound. Memory is bounded by the beam width, and a search that never had to
+// cut a layer is exact. Each layer is expanded on up to `num_threads` threads and merged in a fixed shard order, so
+// the route only depends on the input, not on thread timing or count, unless a limit cuts the search short.
+class FastTravelSolver final {
+public:
+    static constexpr unsigned default_beam_width = 512;
+
+    FastTravelSolver(
+        const GraphData& graph_data,
+        unsigned num_threads = std::thread::hardware_concurrency(),
+        unsigned beam_width = default_beam_width
+    );
+
+    // Once the time budget runs out or the process grows beyond `max_rss_bytes`, the remaining layers keep only their
+    // best state, so the search still finishes with a complete route.
+    void set_limits(const SearchLimits& limits) { this->limits = limits; }
+
+    // Same contract as QuestOptimizer::on_improvement; called from the thread running optimize().
+    void on_improvement(ImprovementCallback callback) { improvement_callback = std::move(callback); }
+
+    // Prints the current layer and beam size at most every `interval_seconds` while optimize() runs, 0 disables it.
+    void log_progress(const float interval_seconds) { log_interval = std::chrono::duration<float>(interval_seconds); }
+
+    // Same as QuestOptimizer::seed_incumbent: the remaining suffix of an earlier route is the route to beat.
+    void seed_incumbent(std::vector<int> previous_route) { this->previous_route = std::move(previous_route); }
+
+    void optimize();
+
+    Path get_best_path() const { return best_path; }
+
+    bool is_proven_optimal() const { return proven_optimal; }
+
+private:
+    struct Coverage {
+        std::vector<int> stops;
+        bool exact = false;
+    };
+
+    const GraphData& graph_data;
+    const unsigned num_threads;
+    const size_t beam_width;
+    SearchLimits limits;
+    ImprovementCallback improvement_callback;
+    std::vector<int> previous_route;
+    std::chrono::steady_clock::time_point deadline;
+    mutable std::atomic<bool> budget_exhausted{false};
+    std::chrono::duration<float> log_interval{0};
+    mutable std::mutex log_mutex;
+    mutable std::chrono::steady_clock::time_point next_log;
+
+    Path best_path = {.vertexes = {}, .length = std::numeric_limits<double>::infinity()};
+    bool proven_optimal = false;
+
+    // Shortest stop sequence completing all quest lines, beginning with `first_stop` unless it is -1.
+    Coverage cover(int first_stop) const;
+
+    // True once a time or memory limit is hit; the first caller to notice reports it.
+    bool out_of_budget() const;
+
+    void log_layer(size_t visited_stops, size_t beam_size) const;
+};
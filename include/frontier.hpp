@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "min_max_heap.hpp"
+#include "search_metrics.hpp"
+
+// Relaxed concurrent priority queue in the MultiQueue style: states live in several independently locked shards,
+// pushes go to a random shard and pops take the better top of two random shards. Ordering follows State::Key only
+// approximately, but no lock is shared by all workers. A single worker gets a single shard and exact ordering.
+// There are never more shards than max_size, so the shard capacities add up to at most max_size.
+//
+// A shard keeps the small ordering keys of its states in a bounded min-max heap and the states themselves in a slab
+// indexed by the heap entries, so popping the best state and evicting the worst one are O(log n) moves within two
+// arrays and no state costs an allocation of its own. Both arrays grow to at most the shard capacity.
+//
+// Termination is detected with a pending counter that covers both queued states and states handed out by try_pop()
+// that have not been reported back through task_done(). Children are pushed before their parent is reported, so
+// the counter can only reach zero once the whole search space is drained.
+//
+// push() and try_pop() optionally record pushes, capacity evictions and time blocked on shard locks into the calling
+// worker's metrics slot.
+template <typename State>
+class Frontier final {
+public:
+    Frontier(const unsigned num_threads, const size_t max_size)
+        : shards(num_threads > 1 ? std::clamp<size_t>(max_size, 1, 2 * size_t{num_threads}) : 1),
+          max_size(max_size),
+          shard_capacity(std::max<size_t>(max_size / shards.size(), 1)) {
+        for (auto& shard : shards) {
+            shard = std::make_unique<Shard>();
+        }
+    }
+
+    // Collapses the shards into one that holds max_size states, so states come out in exact key order and the order
+    // does not depend on the thread count. Callers then use the frontier from one thread. Must be called before the
+    // first push.
+    void make_deterministic() {
+        shards.resize(1);
+        shard_capacity = std::max<size_t>(max_size, 1);
+    }
+
+    // Inserts the state unless its shard is full and the state is not better than the shard's worst one.
+    bool push(State&& state, WorkerMetrics* metrics = nullptr) {
+        const auto key = state.key();
+        auto& shard = *shards[random_shard()];
+        const auto lock = lock_shard(shard, metrics);
+        if (shard.heap.size() >= shard_capacity) {
+            dropped.fetch_add(1, std::memory_order::relaxed);
+            if (metrics != nullptr)
+                metrics->add(WorkerMetrics::evictions);
+            if (!(key < shard.heap.max().key))
+                return false;
+            const std::uint32_t slot = shard.heap.pop_max().slot;
+            shard.states[slot] = std::move(state);
+            shard.heap.push({key, slot});
+            if (metrics != nullptr)
+                metrics->add(WorkerMetrics::pushes);
+            return true;
+        }
+        shard.heap.push({key, store(shard, std::move(state))});
+        queued.fetch_add(1, std::memory_order::relaxed);
+        pending.fetch_add(1, std::memory_order::acq_rel);
+        if (metrics != nullptr)
+            metrics->add(WorkerMetrics::pushes);
+        return true;
+    }
+
+    std::optional<State> try_pop(WorkerMetrics* metrics = nullptr) {
+        for (size_t attempt = 0; attempt < shards.size(); ++attempt) {
+            if (auto state = pop_two_choice())
+                return state;
+        }
+        for (auto& shard : shards) {
+            const auto lock = lock_shard(*shard, metrics);
+            if (!shard->heap.empty())
+                return take_best(*shard);
+        }
+        return std::nullopt;
+    }
+
+    // Reports that a state returned by try_pop() has been fully expanded.
+    void task_done() { pending.fetch_sub(1, std::memory_order::acq_rel); }
+
+    bool exhausted() const { return pending.load(std::memory_order::acquire) == 0; }
+
+    size_t size() const { return queued.load(std::memory_order::relaxed); }
+
+    // Number of states lost to the capacity limit, either rejected or evicted.
+    size_t dropped_count() const { return dropped.load(std::memory_order::relaxed); }
+
+private:
+    using Key = typename State::Key;
+
+    struct Entry {
+        Key key;
+        std::uint32_t slot;
+
+        bool operator<(const Entry& other) const { return key < other.key; }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        MinMaxHeap<Entry> heap;
+        // slab of queued states, a slot is free when listed in free_slots
+        std::vector<State> states;
+        std::vector<std::uint32_t> free_slots;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    const size_t max_size;
+    size_t shard_capacity;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> dropped{0};
+
+    // Takes the shard lock, timing the wait only when the lock is contended so the uncontended path stays cheap.
+    static std::unique_lock<std::mutex> lock_shard(Shard& shard, WorkerMetrics* metrics) {
+        std::unique_lock lock(shard.mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            const auto wait_begin = std::chrono::steady_clock::now();
+            lock.lock();
+            if (metrics != nullptr)
+                metrics->add_time(WorkerMetrics::lock_wait_ns, std::chrono::steady_clock::now() - wait_begin);
+        }
+        return lock;
+    }
+
+    size_t random_shard() const {
+        thread_local std::minstd_rand rng(static_cast<unsigned>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+        return std::uniform_int_distribution<size_t>(0, shards.size() - 1)(rng);
+    }
+
+    std::optional<State> pop_two_choice() {
+        auto& first = *shards[random_shard()];
+        auto& second = *shards[random_shard()];
+        std::unique_lock first_lock(first.mutex, std::try_to_lock);
+        if (!first_lock.owns_lock())
+            return std::nullopt;
+        std::unique_lock<std::mutex> second_lock;
+        if (&second != &first)
+            second_lock = std::unique_lock(second.mutex, std::try_to_lock);
+        Shard* best = first.heap.empty() ? nullptr : &first;
+        if (second_lock.owns_lock() && !second.heap.empty() &&
+            (best == nullptr || second.heap.min().key < best->heap.min().key))
+            best = &second;
+        if (best == nullptr)
+            return std::nullopt;
+        return take_best(*best);
+    }
+
+    // Capacity of a growing shard array: doubled as usual, but never beyond what a full shard needs.
+    size_t grown_capacity(const size_t capacity) const {
+        return std::min(std::max<size_t>(2 * capacity, 16), shard_capacity);
+    }
+
+    std::uint32_t store(Shard& shard, State&& state) {
+        if (!shard.free_slots.empty()) {
+            const std::uint32_t slot = shard.free_slots.back();
+            shard.free_slots.pop_back();
+            shard.states[slot] = std::move(state);
+            return slot;
+        }
+        if (shard.states.size() == shard.states.capacity())
+            shard.states.reserve(grown_capacity(shard.states.capacity()));
+        if (shard.heap.size() == shard.heap.capacity())
+            shard.heap.reserve(grown_capacity(shard.heap.capacity()));
+        shard.states.push_back(std::move(state));
+        return static_cast<std::uint32_t>(shard.states.size() - 1);
+    }
+
+    State take_best(Shard& shard) {
+        const std::uint32_t slot = shard.heap.pop_min().slot;
+        State state = std::move(shard.states[slot]);
+        shard.free_slots.push_back(slot);
+        queued.fetch_sub(1, std::memory_order::relaxed);
+        return state;
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "parser.hpp"
+
+// Versioned binary snapshot of a parsed GraphData. The CSR arrays are stored 8-byte aligned and used in place from
+// the memory-mapped cache file; only vertex names and quest lines are copied out on load. Every cache records a
+// hash of the text map it was built from, and a cache with another hash or format version is ignored.
+class GraphCache final {
+public:
+    static constexpr std::uint32_t format_version = 1;
+
+    static std::uint64_t hash_file(const std::string& file_path);
+
+    static void write(const std::string& cache_path, const GraphData& graph_data, std::uint64_t source_hash);
+
+    // Returns nullopt if the cache is missing, malformed, of another version or built from different source bytes.
+    static std::optional<GraphData> read(const std::string& cache_path, std::uint64_t source_hash);
+
+    // Loads `cache_path` if it matches `source_path`, otherwise parses the source on `num_threads` threads and
+    // rewrites the cache.
+    static GraphData load_or_parse(
+        const std::string& source_path,
+        const std::string& cache_path,
+        unsigned num_threads = std::thread::hardware_concurrency()
+    );
+};
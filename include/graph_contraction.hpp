@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "parser.hpp"
+#include "path_store.hpp"
+
+// Preprocessing pass that shrinks a walking map to the part a route can use. Vertices that no route between quest
+// stops and the start can pass through are removed, and every other non-stop vertex with at most two neighbours is
+// contracted into shortcut edges between them, so corridors collapse into single weighted edges. Shortest distances
+// between the kept vertices are unchanged, and each shortcut remembers the vertex it bypasses, so routes over the
+// reduced graph expand back to the original vertices.
+class GraphContraction final {
+public:
+    explicit GraphContraction(const GraphData& graph_data);
+
+    // The kept vertices renumbered densely, with quest lines, start and vertex names mapped to the new ids.
+    const GraphData& reduced() const { return reduced_graph; }
+
+    int original_vertex(const int reduced_vertex) const { return original_vertexes[reduced_vertex]; }
+
+    // The same route in original vertex ids and of the same length, with every shortcut unpacked.
+    Path expand(const Path& reduced_route) const;
+
+private:
+    static constexpr int original_edge = -1;
+
+    // A shortcut walks its `first` arc to `via`, then its `second` arc; arcs are original edges or shortcuts.
+    struct Shortcut {
+        int first;
+        int via;
+        int second;
+    };
+
+    GraphData reduced_graph;
+    std::vector<int> original_vertexes;
+    std::vector<Shortcut> shortcuts;
+    // Shortcut of every reduced edge in CSR order, original_edge for an edge of the input map.
+    std::vector<int> edge_shortcuts;
+
+    void unpack(int shortcut, std::vector<int>& vertexes) const;
+};
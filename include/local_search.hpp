@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "distance_oracle.hpp"
+#include "parser.hpp"
+#include "path_store.hpp"
+
+// Precedence-preserving local search over the quest stops of a route. A route is unrolled into one task per quest
+// stop, then improved with Or-opt segment moves, swaps and 2-opt segment reversals whose cost change is evaluated in
+// O(1) from stop-to-stop distances. Stops of one quest line never change their relative order, so every refined
+// route still completes all quest lines.
+class LocalSearch final {
+public:
+    // `oracle` gives walking distances between quest stops, nullptr for fast travel where every move costs 1.
+    // A non-fast-travel route is walked from `graph_data.start_index` when there is one.
+    LocalSearch(const GraphData& graph_data, const DistanceOracle* oracle);
+
+    // Makes refine() stop between moves once `deadline` passes or the process grows beyond `max_rss_bytes` (0 for no
+    // memory limit), returning the route reached so far.
+    void set_budget(const std::chrono::steady_clock::time_point deadline, const size_t max_rss_bytes) {
+        this->deadline = deadline;
+        this->max_rss_bytes = max_rss_bytes;
+    }
+
+    // Length of a route over quest stops, measured the way QuestOptimizer measures its states.
+    double route_cost(const std::vector<int>& stop_route) const;
+
+    // Locally optimal route for the same quest lines as `stop_route`, never longer than it.
+    Path refine(const std::vector<int>& stop_route) const;
+
+private:
+    const GraphData& graph_data;
+    const DistanceOracle* oracle;
+    const int start_vertex;
+    std::vector<int> task_vertex;
+    std::vector<int> task_quest;
+    std::vector<int> previous_task;
+    std::vector<int> next_task;
+    std::vector<size_t> first_task_of_quest;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    size_t max_rss_bytes = 0;
+
+    double distance(int from_vertex, int to_vertex) const;
+
+    std::vector<int> unroll(const std::vector<int>& stop_route) const;
+
+    std::vector<int> roll_up(const std::vector<int>& task_order) const;
+};
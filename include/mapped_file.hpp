@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped; elsewhere it is read into memory once.
+class MappedFile final {
+public:
+    explicit MappedFile(const std::string& file_path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view view() const { return {data, size}; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    std::string fallback_buffer;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <thread>
+
+#include "parser.hpp"
+
+// Entry point used by the CLI and the graph cache. It runs the same memory-mapped, chunked tokenizer and validation
+// as Parser, so both load paths accept the same files and produce the same graph.
+class MappedParser final {
+public:
+    static GraphData parse_file(const std::string& file_path, unsigned num_threads = std::thread::hardware_concurrency());
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Current resident set size of the process in bytes, or 0 where the platform does not expose it.
+size_t resident_set_bytes();
+
+// Highest resident set size of the process since it started or since the last reset_peak_resident_set().
+size_t peak_resident_set_bytes();
+
+// Starts a new peak measurement where the platform allows it; the peak keeps covering the whole process otherwise.
+void reset_peak_resident_set();
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include <vector>
+
+// Double-ended priority queue in one contiguous array (Atkinson et al.): even tree levels are ordered as a min-heap
+// and odd levels as a max-heap, so both the smallest and the largest entry are at most two slots from the root.
+// Push, pop_min and pop_max are O(log n) and only move entries within the array. Entries are ordered by operator<.
+template <typename Entry>
+class MinMaxHeap final {
+public:
+    bool empty() const { return entries.empty(); }
+
+    size_t size() const { return entries.size(); }
+
+    void reserve(const size_t capacity) { entries.reserve(capacity); }
+
+    size_t capacity() const { return entries.capacity(); }
+
+    const Entry& min() const { return entries.front(); }
+
+    const Entry& max() const { return entries[max_index()]; }
+
+    void push(const Entry& entry) {
+        entries.push_back(entry);
+        bubble_up(entries.size() - 1);
+    }
+
+    Entry pop_min() { return remove(0); }
+
+    Entry pop_max() { return remove(max_index()); }
+
+private:
+    std::vector<Entry> entries;
+
+    static bool on_min_level(const size_t index) { return std::bit_width(index + 1) % 2 == 1; }
+
+    static size_t parent(const size_t index) { return (index - 1) / 2; }
+
+    size_t max_index() const {
+        if (entries.size() < 3)
+            return entries.size() - 1;
+        return entries[1] < entries[2] ? 2 : 1;
+    }
+
+    Entry remove(const size_t index) {
+        Entry removed = entries[index];
+        entries[index] = entries.back();
+        entries.pop_back();
+        if (index < entries.size())
+            trickle_down(index);
+        return removed;
+    }
+
+    // `before(a, b)` is a < b on min levels and b < a on max levels.
+    template <bool MinLevel>
+    static bool before(const Entry& a, const Entry& b) {
+        if constexpr (MinLevel)
+            return a < b;
+        else
+            return b < a;
+    }
+
+    void bubble_up(const size_t index) {
+        if (index == 0)
+            return;
+        const size_t up = parent(index);
+        if (on_min_level(index)) {
+            if (entries[up] < entries[index]) {
+                std::swap(entries[up], entries[index]);
+                bubble_up_grandparents<false>(up);
+            } else {
+                bubble_up_grandparents<true>(index);
+            }
+        } else if (entries[index] < entries[up]) {
+            std::swap(entries[up], entries[index]);
+            bubble_up_grandparents<true>(up);
+        } else {
+            bubble_up_grandparents<false>(index);
+        }
+    }
+
+    template <bool MinLevel>
+    void bubble_up_grandparents(size_t index) {
+        while (index > 2) {
+            const size_t grandparent = parent(parent(index));
+            if (!before<MinLevel>(entries[index], entries[grandparent]))
+                return;
+            std::swap(entries[index], entries[grandparent]);
+            index = grandparent;
+        }
+    }
+
+    void trickle_down(const size_t index) {
+        if (on_min_level(index))
+            trickle_down_level<true>(index);
+        else
+            trickle_down_level<false>(index);
+    }
+
+    template <bool MinLevel>
+    void trickle_down_level(size_t index) {
+        const size_t count = entries.size();
+        while (2 * index + 1 < count) {
+            // most extreme of the children and grandchildren
+            size_t best = 2 * index + 1;
+            if (best + 1 < count && before<MinLevel>(entries[best + 1], entries[best]))
+                best = best + 1;
+            for (size_t grandchild = 4 * index + 3; grandchild < std::min(4 * index + 7, count); ++grandchild) {
+                if (before<MinLevel>(entries[grandchild], entries[best]))
+                    best = grandchild;
+            }
+            if (!before<MinLevel>(entries[best], entries[index]))
+                return;
+            std::swap(entries[best], entries[index]);
+            if (best <= 2 * index + 2)
+                return;
+            if (before<MinLevel>(entries[parent(best)], entries[best]))
+                std::swap(entries[parent(best)], entries[best]);
+            index = best;
+        }
+    }
+};
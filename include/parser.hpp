@@ -1,8 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <thread>
 #include <vector>
 
 class InvalidFormat final : public std::runtime_error {
@@ -21,45 +23,91 @@ struct Edge {
     double weight;
 };
 
-struct GraphData {
-    std::vector<std::vector<Edge>> adj_list;
-    bool fast_travel;
-    bool weighted;
-    bool bidirectional;
-    int vertex_count;
-    int start_index = -1;
-    std::vector<std::string> vertex_names;
-    std::vector<QuestLine> quest_lines;
+struct EdgeRecord {
+    int from;
+    int to;
+    double weight;
 };
 
-using LineIter = std::vector<std::string>::iterator;
+// Immutable compressed sparse row adjacency: edges of vertex v are [offsets[v], offsets[v + 1]) in `targets` and
+// `weights`, sorted by target. The arrays are views into shared storage, which is either owned vectors or a
+// memory-mapped graph cache, so copies are cheap and share the same edges.
+struct CsrGraph {
+    std::span<const int> offsets;
+    std::span<const int> targets;
+    std::span<const double> weights;
 
-class Parser {
-public:
-    static GraphData parse_file(const std::string& file_path);
+    static CsrGraph from_arrays(std::vector<int> offsets, std::vector<int> targets, std::vector<double> weights);
 
-private:
-    static std::vector<std::string> lines;
-    static LineIter current_line;
-    static GraphData graph_data;
+    static CsrGraph from_adjacency(const std::vector<std::vector<Edge>>& adj_list);
+
+    // Builds the graph from edges in file order; a repeated (from, to) pair keeps the weight of its last occurrence.
+    // Per-vertex sorting and merging is split across `num_threads` threads.
+    static CsrGraph from_edge_list(int vertex_count, const std::vector<EdgeRecord>& edges, unsigned num_threads = 1);
+
+    // Wraps arrays owned by `backing` without copying them.
+    static CsrGraph view(
+        std::span<const int> offsets,
+        std::span<const int> targets,
+        std::span<const double> weights,
+        std::shared_ptr<const void> backing
+    );
+
+    int edge_begin(const int vertex) const { return offsets[vertex]; }
+
+    int edge_end(const int vertex) const { return offsets[vertex + 1]; }
 
-    static void read_file(const std::string& file_path);
+    int out_degree(const int vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
 
-    static const std::unordered_map<std::string, void (*)()> string_to_parse_func;
+    int edge_count() const { return static_cast<int>(targets.size()); }
 
-    static void parse_fast_travel();
+private:
+    std::shared_ptr<const void> backing;
+};
 
-    static void parse_bidirectional();
+// Inverted index of quest stops: the (quest_id, position) pairs at which vertex v is a quest stop are
+// [offsets[v], offsets[v + 1]) in `stops`, sorted by quest id and then position.
+struct QuestStopIndex {
+    struct Stop {
+        int quest_id;
+        int position;
+    };
 
-    static void parse_weighted();
+    std::vector<int> offsets;
+    std::vector<Stop> stops;
 
-    static void parse_vertex_count();
+    static QuestStopIndex build(const std::vector<QuestLine>& quest_lines, int vertex_count);
 
-    static void parse_vertexes();
+    std::span<const Stop> stops_at(const int vertex) const {
+        return std::span(stops).subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+    }
+};
 
-    static void parse_edges();
+struct GraphData {
+    CsrGraph graph;
+    bool fast_travel;
+    bool weighted;
+    bool bidirectional;
+    int vertex_count;
+    int start_index = -1;
+    std::vector<std::string> vertex_names;
+    std::vector<QuestLine> quest_lines;
+    // Built from `quest_lines` by every producer of a GraphData; rebuild it after changing them.
+    QuestStopIndex stop_index;
+};
+
+// Parser of the text map format. The file is memory-mapped and tokenized in place with std::from_chars; the
+// Edges and QuestLines sections are split into line-aligned chunks tokenized on `num_threads` threads, and the
+// per-vertex edge merge runs on the same threads. A Parser holds no parsing state, so one instance can load maps
+// concurrently.
+class Parser final {
+public:
+    explicit Parser(unsigned num_threads = std::thread::hardware_concurrency());
+
+    GraphData parse(const std::string& file_path) const;
 
-    static void parse_quest_lines();
+    static GraphData parse_file(const std::string& file_path);
 
-    static void parse_start();
+private:
+    const unsigned num_threads;
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+struct Path {
+    std::vector<int> vertexes;
+    double length = 0.0;
+
+    Path& operator+=(const Path& other) {
+        vertexes.insert(vertexes.end(), other.vertexes.begin(), other.vertexes.end());
+        length += other.length;
+        return *this;
+    }
+};
+
+using PathHandle = std::uint32_t;
+
+// Append-only arena of parent-pointer path nodes shared by all workers. A search state keeps only the handle of
+// its last node, so extending a path is O(1) and the full vertex sequence is materialized on demand.
+class PathStore final {
+public:
+    static constexpr PathHandle empty_path = UINT32_MAX;
+
+    PathStore() = default;
+    PathStore(const PathStore&) = delete;
+    PathStore& operator=(const PathStore&) = delete;
+    ~PathStore();
+
+    // Throws std::length_error once all 2^32 - 1 node handles are used.
+    PathHandle append(PathHandle parent, int vertex);
+
+    // Same as append(), but returns nullopt instead of throwing when the arena is full.
+    std::optional<PathHandle> try_append(PathHandle parent, int vertex);
+
+    std::vector<int> materialize(PathHandle handle) const;
+
+    size_t node_count() const { return next_node.load(std::memory_order::relaxed); }
+
+private:
+    struct Node {
+        PathHandle parent;
+        int vertex;
+    };
+
+    static constexpr size_t chunk_bits = 16;
+    static constexpr size_t chunk_size = size_t{1} << chunk_bits;
+    static constexpr size_t max_chunks = (size_t{1} << 32) / chunk_size;
+
+    std::atomic<size_t> next_node{0};
+    std::array<std::atomic<Node*>, max_chunks> chunks{};
+
+    Node* chunk_for(size_t node_index);
+
+    const Node& node(const PathHandle handle) const {
+        return chunks[handle >> chunk_bits].load(std::memory_order::acquire)[handle & (chunk_size - 1)];
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "distance_oracle.hpp"
+#include "parser.hpp"
+#include "path_store.hpp"
+#include "quest_optimizer_x.hpp"
+
+// Portfolio of independent single-threaded QuestOptimizer searches over a walking map. The route starts are split
+// round-robin into groups, and every group is searched with its own error_afford and queue size, so good starts do
+// not compete for one global queue. Members run on a pool of `num_threads` workers and prune with one shared best
+// length.
+class PortfolioSolver final {
+public:
+    static constexpr unsigned members_per_thread = 2;
+
+    PortfolioSolver(
+        const GraphData& graph_data,
+        unsigned num_threads = std::thread::hardware_concurrency(),
+        unsigned max_queue_size = 100000,
+        double error_afford = 1.05,
+        unsigned depth_of_search = 1,
+        std::shared_ptr<const DistanceOracle> oracle = nullptr
+    );
+
+    // The time budget is shared out as members start: each gets an equal part of what is left for the members that
+    // have not started yet, so later groups still run when earlier ones use all of theirs.
+    void set_limits(const SearchLimits& limits) { this->limits = limits; }
+
+    // Members run deterministic searches and keep their best length to themselves, so the route does not depend on
+    // which member finishes first. Members then cannot prune with each other's routes.
+    void set_deterministic(const bool deterministic) { this->deterministic = deterministic; }
+
+    // Same contract as QuestOptimizer::on_improvement, across all members.
+    void on_improvement(ImprovementCallback callback) { improvement_callback = std::move(callback); }
+
+    void optimize();
+
+    Path get_best_path() const { return best_path; }
+
+    // True when every member exhausted its group without lossy pruning.
+    bool is_proven_optimal() const { return proven_optimal; }
+
+private:
+    const GraphData& graph_data;
+    const unsigned num_threads;
+    const unsigned max_queue_size;
+    const double error_afford;
+    const unsigned depth_of_search;
+    std::shared_ptr<const DistanceOracle> oracle;
+
+    SearchLimits limits;
+    bool deterministic = false;
+    ImprovementCallback improvement_callback;
+
+    std::atomic<double> shared_incumbent{std::numeric_limits<double>::infinity()};
+    std::mutex improvement_mutex;
+    double published_length = std::numeric_limits<double>::infinity();
+    Path best_path = {.vertexes = {}, .length = std::numeric_limits<double>::infinity()};
+    bool proven_optimal = false;
+};
@@ -2,34 +2,39 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <limits>
-#include <memory_resource>
+#include <memory>
 #include <mutex>
+#include <ostream>
 #include <ranges>
-#include <set>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "distance_oracle.hpp"
+#include "frontier.hpp"
 #include "parser.hpp"
-
-struct Path {
-    std::vector<int> vertexes;
-    double length = 0.0;
-
-    Path& operator+=(const Path& other) {
-        vertexes.insert(vertexes.end(), other.vertexes.begin(), other.vertexes.end());
-        length += other.length;
-        return *this;
-    }
-};
+#include "path_store.hpp"
+#include "quest_progress.hpp"
+#include "search_metrics.hpp"
+#include "stop_reachability.hpp"
 
 int remain_quests(std::vector<QuestLine>::const_iterator first, std::vector<QuestLine>::const_iterator last);
 
+// Stops of the shortest suffix of `route` that still completes every quest line, without the vertices that advance
+// no line. Empty if `route` does not complete them all.
+std::vector<int> remaining_stop_route(const std::vector<QuestLine>& quest_lines, const std::vector<int>& route);
+
+// Prints the length and, for every vertex of the route, the quest lines it advances; only the stops indexed at each
+// vertex are looked at. Returns whether the route completes every quest line.
 bool print_quests_on_path(
     const Path& path,
     const std::vector<QuestLine>& quest_lines,
+    const QuestStopIndex& stop_index,
     const std::vector<std::string>& vertex_names,
     bool use_vertex_names,
     bool use_quest_names
@@ -37,20 +42,48 @@ bool print_quests_on_path(
 
 struct PathState {
     int current_index;
-    Path path;
-    std::vector<size_t> quest_positions;
+    PathHandle path;
+    double length;
+    // length plus an admissible lower bound of the distance still to travel
+    double estimate;
+    QuestProgress quest_progress;
     int remaining_quest_count;
 
-    bool operator<(const PathState& other) const {
-        if (remaining_quest_count != other.remaining_quest_count) {
-            return remaining_quest_count < other.remaining_quest_count;
+    // Ordering of queued states: fewest remaining quests first, then the smallest estimate. Kept to 24 bytes, so a
+    // frontier heap entry holding it and a slot index fills half a cache line.
+    struct Key {
+        double estimate;
+        double length;
+        int remaining_quest_count;
+        int current_index;
+
+        bool operator<(const Key& other) const {
+            if (remaining_quest_count != other.remaining_quest_count)
+                return remaining_quest_count < other.remaining_quest_count;
+            if (estimate != other.estimate)
+                return estimate < other.estimate;
+            if (length != other.length)
+                return length < other.length;
+            return current_index < other.current_index;
         }
-        if (path.length != other.path.length)
-            return path.length < other.path.length;
-        return current_index < other.current_index;
-    }
+    };
+
+    Key key() const { return {estimate, length, remaining_quest_count, current_index}; }
+};
+
+// Budgets after which optimize() stops and keeps the best path found so far; zero means unlimited.
+struct SearchLimits {
+    std::chrono::milliseconds time_budget{0};
+    // Resident set size of the whole process, checked a few hundred times per second.
+    size_t max_rss_bytes = 0;
 };
 
+// Called with the complete route every time the search finds a shorter one.
+using ImprovementCallback = std::function<void(const Path&)>;
+
+// Queue search over walking maps; fast travel maps are solved by FastTravelSolver and rejected here.
+// `oracle` may be a precomputed DistanceOracle whose stops cover the quest stops and start vertex of `graph_data`,
+// which lets repeated searches over one map skip the shortest path preprocessing. It is built on demand otherwise.
 class QuestOptimizer final {
 public:
     explicit QuestOptimizer(
@@ -59,7 +92,8 @@ public:
         const unsigned max_queue_size = 100000,
         const double error_afford = 1.05,
         const unsigned depth_of_search = 1,
-        const float log_interval_seconds = 1.0
+        const float log_interval_seconds = 1.0,
+        std::shared_ptr<const DistanceOracle> oracle = nullptr
     )
         : graph_data(graph_data),
           num_threads(num_threads),
@@ -68,16 +102,64 @@ public:
           depth_of_search(depth_of_search),
           log_interval_seconds(log_interval_seconds),
           total_quest_count(remain_quests(graph_data.quest_lines.begin(), graph_data.quest_lines.end())),
-          minimum_quest_count(total_quest_count) {
+          minimum_quest_count(total_quest_count),
+          progress_layout(graph_data.quest_lines),
+          dominance(dominance_entries_per_queue_slot * std::max<size_t>(max_queue_size, 1)),
+          frontier(num_threads, max_queue_size),
+          search_metrics(num_threads),
+          oracle(std::move(oracle)) {
         std::ranges::for_each(std::views::iota(0, graph_data.vertex_count), [&](const int i) {
             best_path_for_start[i] = Path({}, std::numeric_limits<double>::infinity());
         });
     };
 
+    // Route of an earlier solution, e.g. from before the player advanced some quest lines. The shortest suffix of it
+    // that still completes every quest line becomes the initial incumbent, so the search only has to improve on it.
+    void seed_incumbent(std::vector<int> previous_route) { this->previous_route = std::move(previous_route); }
+
+    void set_limits(const SearchLimits& limits) { this->limits = limits; }
+
+    // Runs the search in synchronous rounds: the best states are taken off the frontier in a fixed order, every worker
+    // expands a fixed slice of them and the children are merged back in batch order. The route then only depends on
+    // the input, not on thread timing or count, as long as no time or memory limit cuts the search short.
+    void set_deterministic(const bool deterministic) { this->deterministic = deterministic; }
+
+    // Streams improving routes while optimize() runs. The callback is invoked from worker threads, one call at a time
+    // and with strictly decreasing lengths.
+    void on_improvement(ImprovementCallback callback) { improvement_callback = std::move(callback); }
+
+    // Writes a JSON lines snapshot of the per-worker search counters to `out` every `interval_seconds` while
+    // optimize() runs, and a final one once it stops.
+    void report_metrics(std::ostream& out, const float interval_seconds) {
+        metrics_out = &out;
+        metrics_interval_seconds = interval_seconds;
+    }
+
+    // Makes this search one member of a portfolio: only `seeds` start routes, and pruning uses the best length
+    // found by any member. Optimality then only holds for the member's own seeds. `reachability` is the analysis of
+    // the map shared by all members.
+    void join_portfolio(
+        std::atomic<double>& shared_incumbent,
+        std::vector<int> seeds,
+        std::shared_ptr<const StopReachability> reachability
+    );
+
+    // Vertices a route may start from: the quest stops and the start, restricted to the first component a route can
+    // begin in when `reachability` is given.
+    static std::vector<int> seed_vertices(const GraphData& graph_data, const StopReachability* reachability = nullptr);
+
     void optimize();
 
     Path get_best_path() const;
 
+    // Number of states taken off the queue and expanded so far.
+    size_t expanded_states() const { return path_store.node_count(); }
+
+    const SearchMetrics& metrics() const { return search_metrics; }
+
+    // True when the search drained without any lossy pruning, so the best path is optimal.
+    bool is_proven_optimal() const { return proven_optimal; }
+
 private:
     const GraphData& graph_data;
     const unsigned num_threads;
@@ -87,22 +169,95 @@ private:
     const float log_interval_seconds;
     int total_quest_count;
 
+    // Number of the best complete paths polished by local search once the search stops.
+    static constexpr size_t refine_candidate_count = 16;
+    // Dominance keys kept per queue slot, so the table is bounded by max_queue_size like the queue.
+    static constexpr size_t dominance_entries_per_queue_slot = 32;
+    // States expanded per round of a deterministic search.
+    static constexpr size_t deterministic_batch_size = 64;
+
     std::atomic<unsigned> found_best_paths = 0;
     std::atomic<unsigned> minimum_quest_count;
     std::unordered_map<int, Path> best_path_for_start;
     Path best_path = {.vertexes = {}, .length = std::numeric_limits<double>::infinity()};
+    std::atomic<double> own_incumbent_length{std::numeric_limits<double>::infinity()};
+    // Best complete length known to this search, shared with the other members when it is part of a portfolio.
+    std::atomic<double>* incumbent_length = &own_incumbent_length;
+    std::vector<int> portfolio_seeds;
+    std::atomic<bool> search_truncated{false};
+    bool proven_optimal = false;
+    bool deterministic = false;
 
-    std::pmr::unsynchronized_pool_resource queue_pool{};
-    std::pmr::set<PathState> queue{&queue_pool};
-    std::condition_variable cv_queue;
-    unsigned sleeping_threads = 0;
-    std::mutex queue_mutex;
+    ProgressLayout progress_layout;
+    DominanceTable dominance;
+    PathStore path_store;
+    Frontier<PathState> frontier;
+    SearchMetrics search_metrics;
+    std::mutex best_path_mutex;
     std::atomic<bool> stop_event{false};
 
-    std::unordered_map<int, Path> dijkstra_from(int start) const;
+    std::shared_ptr<const DistanceOracle> oracle;
+    // Component chain of a walking map: a state only moves on to stops of the earliest rank it has not finished.
+    std::shared_ptr<const StopReachability> reachability;
+    std::vector<int> previous_route;
+
+    SearchLimits limits;
+    std::mutex watchdog_mutex;
+    std::condition_variable watchdog_wakeup;
+
+    std::ostream* metrics_out = nullptr;
+    float metrics_interval_seconds = 1.0;
+
+    ImprovementCallback improvement_callback;
+    std::mutex publish_mutex;
+    double published_length = std::numeric_limits<double>::infinity();
+    std::vector<size_t> chain_offsets;
+    std::vector<double> chain_suffix_lengths;
+
+    // Next stop of every unfinished quest line of the state being expanded, decoded once per expansion into parallel
+    // arrays so that the bound of each child is a single gather-add-max pass over them.
+    struct OpenQuests {
+        std::vector<int> next_vertexes;
+        std::vector<int> next_stops;
+        std::vector<double> suffix_lengths;
+        // expansion number that last generated a child at each stop, so lines waiting at one stop share a child
+        std::vector<std::uint32_t> generated_at;
+        std::uint32_t expansion = 0;
+    };
+
+    enum class Expansion { gated, complete, expanded };
 
-    bool update_state(PathState& current_state);
-    bool update_state_fast_travel(PathState& current_state);
+    Expansion expand_state(
+        PathState& state,
+        unsigned minimum_quests,
+        WorkerMetrics& metrics,
+        OpenQuests& open_quests,
+        std::vector<PathState>* deferred_children
+    );
+    void expand_walking(
+        const PathState& state,
+        WorkerMetrics& metrics,
+        OpenQuests& open_quests,
+        std::vector<PathState>* deferred_children
+    );
+    void emit_child(PathState&& child, WorkerMetrics& metrics, std::vector<PathState>* deferred_children);
+    bool update_state(PathState& current_state, WorkerMetrics& metrics, OpenQuests& open_quests);
+    void finish_expansion(const PathState& state, bool found);
+    void advance_quests(PathState& state) const;
+    void record_complete_path(const PathState& state);
+    Path complete_route(const Path& coverage) const;
+    void publish_if_improved(const Path& coverage);
+    void watch_limits(std::chrono::steady_clock::time_point deadline);
+    void report_metrics_periodically();
+    void push_state(PathState&& state, WorkerMetrics* metrics = nullptr);
+    void build_chain_bounds();
+    void record_previous_route_suffix();
+    void record_coverage(Path coverage);
+    bool complete_best_state_greedily();
+    void refine_best_paths(std::chrono::steady_clock::time_point deadline);
+    double lower_bound(int vertex, const QuestProgress& progress) const;
+    PathState make_state(int vertex, double length, const QuestProgress& progress) const;
 
-    void optimize_cycle();
+    void optimize_cycle(unsigned worker);
+    void optimize_rounds();
 };
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "parser.hpp"
+
+// Quest line positions packed into fixed-width bit fields. Up to `inline_words` 64-bit words are stored in place,
+// so typical states do not allocate; the Zobrist hash is maintained incrementally by ProgressLayout.
+class QuestProgress final {
+public:
+    static constexpr size_t inline_words = 4;
+
+    QuestProgress() = default;
+
+    explicit QuestProgress(const size_t word_count) : word_count(static_cast<std::uint32_t>(word_count)) {
+        if (word_count > inline_words)
+            heap_words = std::make_unique<std::uint64_t[]>(word_count);
+    }
+
+    QuestProgress(const QuestProgress& other) : hash(other.hash), word_count(other.word_count) {
+        if (other.heap_words) {
+            heap_words = std::make_unique<std::uint64_t[]>(word_count);
+            std::copy_n(other.heap_words.get(), word_count, heap_words.get());
+        } else {
+            inline_storage = other.inline_storage;
+        }
+    }
+
+    QuestProgress(QuestProgress&&) noexcept = default;
+
+    QuestProgress& operator=(const QuestProgress& other) {
+        if (this != &other)
+            *this = QuestProgress(other);
+        return *this;
+    }
+
+    QuestProgress& operator=(QuestProgress&&) noexcept = default;
+
+    ~QuestProgress() = default;
+
+    std::uint64_t* words() { return heap_words ? heap_words.get() : inline_storage.data(); }
+
+    const std::uint64_t* words() const { return heap_words ? heap_words.get() : inline_storage.data(); }
+
+    size_t size() const { return word_count; }
+
+    bool operator==(const QuestProgress& other) const {
+        return hash == other.hash && word_count == other.word_count &&
+               std::equal(words(), words() + word_count, other.words());
+    }
+
+    std::uint64_t hash = 0;
+
+private:
+    std::array<std::uint64_t, inline_words> inline_storage{};
+    std::unique_ptr<std::uint64_t[]> heap_words;
+    std::uint32_t word_count = 0;
+};
+
+// Bit layout of a QuestProgress for one set of quest lines, plus the Zobrist table used for its hash.
+class ProgressLayout final {
+public:
+    explicit ProgressLayout(const std::vector<QuestLine>& quest_lines);
+
+    QuestProgress initial() const;
+
+    size_t position(const QuestProgress& progress, size_t quest_id) const;
+
+    void advance(QuestProgress& progress, size_t quest_id) const;
+
+private:
+    struct Field {
+        std::uint32_t bit_offset;
+        std::uint32_t bit_width;
+        std::uint32_t zobrist_offset;
+    };
+
+    std::vector<Field> fields;
+    std::vector<std::uint64_t> zobrist;
+    size_t word_count = 0;
+
+    void set_position(QuestProgress& progress, size_t quest_id, size_t position) const;
+};
+
+// Concurrent table of the shortest known length for every (vertex, quest progress) key. A state whose key has
+// already been reached at least as cheaply is dominated and can be dropped. Keys are compared in full, so a hash
+// collision never drops a state. Once `max_entries` keys are known, new keys are no longer recorded: the search then
+// prunes less but stays correct.
+class DominanceTable final {
+public:
+    explicit DominanceTable(size_t max_entries = std::numeric_limits<size_t>::max())
+        : shard_capacity(std::max<size_t>(max_entries / shard_count, 1)) {}
+
+    // Records `length` for the key and returns true if it strictly improves on the best known length.
+    bool try_improve(int vertex, const QuestProgress& progress, double length);
+
+    // True if a strictly shorter length than `length` is known for the key.
+    bool dominated(int vertex, const QuestProgress& progress, double length);
+
+private:
+    static constexpr size_t shard_count = 64;
+
+    struct Key {
+        int vertex;
+        QuestProgress progress;
+    };
+
+    // Borrowed key, so lookups do not copy the progress.
+    struct KeyView {
+        int vertex;
+        const QuestProgress& progress;
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+
+        size_t operator()(const Key& key) const { return hash_of(key.vertex, key.progress); }
+
+        size_t operator()(const KeyView& key) const { return hash_of(key.vertex, key.progress); }
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return a.vertex == b.vertex && a.progress == b.progress;
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, double, KeyHash, KeyEqual> best_lengths;
+    };
+
+    std::array<Shard, shard_count> shards;
+    const size_t shard_capacity;
+
+    static std::uint64_t hash_of(int vertex, const QuestProgress& progress);
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Counters of one search worker. A slot has a single writer and a cache line of its own, so recording is a relaxed
+// load and store without any contention; readers aggregating the slots see values that are at most slightly stale.
+class alignas(64) WorkerMetrics final {
+public:
+    enum Counter : size_t {
+        // states taken off the frontier and expanded
+        expansions,
+        // states inserted into the frontier
+        pushes,
+        // states lost to max_queue_size, either evicted from a full shard or refused by it
+        evictions,
+        // states dropped because their estimate cannot beat the best complete length
+        bound_prunes,
+        // states dropped because a shorter path reached the same vertex with the same progress
+        dominated,
+        // states not expanded because they are too far behind minimum_quest_count times error_afford
+        error_afford_rejections,
+        // time blocked on a contended frontier shard lock
+        lock_wait_ns,
+        // time spent waiting for work while the frontier had nothing to hand out
+        idle_ns,
+        counter_count
+    };
+
+    static constexpr std::array<const char*, counter_count> counter_names = {
+        "expansions",
+        "pushes",
+        "evictions",
+        "bound_prunes",
+        "dominated",
+        "error_afford_rejections",
+        "lock_wait_ns",
+        "idle_ns",
+    };
+
+    void add(const Counter counter, const std::uint64_t amount = 1) {
+        auto& value = values[counter];
+        value.store(value.load(std::memory_order::relaxed) + amount, std::memory_order::relaxed);
+    }
+
+    void add_time(const Counter counter, const std::chrono::steady_clock::duration duration) {
+        add(counter, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    std::uint64_t get(const Counter counter) const { return values[counter].load(std::memory_order::relaxed); }
+
+private:
+    std::array<std::atomic<std::uint64_t>, counter_count> values{};
+};
+
+using MetricTotals = std::array<std::uint64_t, WorkerMetrics::counter_count>;
+
+// Per-worker counters of one search, aggregated on demand. Snapshots are written as JSON lines, one object per line:
+// {"elapsed_ms":..,"queue_size":..,"best_length":..,"final":..,"total":{..},"workers":[{..},..]}
+class SearchMetrics final {
+public:
+    explicit SearchMetrics(unsigned num_workers);
+
+    WorkerMetrics& worker(const unsigned index) { return slots[index]; }
+
+    MetricTotals totals() const;
+
+    void write_snapshot(std::ostream& out, size_t queue_size, double best_length, bool final) const;
+
+private:
+    std::vector<WorkerMetrics> slots;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
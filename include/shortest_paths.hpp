@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "parser.hpp"
+
+// Min-heap of (key, item) pairs with lazy deletion: callers skip popped entries whose key is stale. Storage is kept
+// across clear() so a reused heap stops allocating once it has grown to the working size.
+class DaryHeap final {
+public:
+    static constexpr int arity = 4;
+
+    struct Entry {
+        double key;
+        int item;
+    };
+
+    bool empty() const { return heap.empty(); }
+
+    void push(const int item, const double key) {
+        heap.push_back({key, item});
+        sift_up(static_cast<int>(heap.size()) - 1);
+    }
+
+    Entry pop() {
+        const Entry top = heap.front();
+        const Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap.front() = last;
+            sift_down(0);
+        }
+        return top;
+    }
+
+    void clear() { heap.clear(); }
+
+private:
+    std::vector<Entry> heap;
+
+    void sift_up(int position) {
+        const Entry entry = heap[position];
+        while (position > 0) {
+            const int parent = (position - 1) / arity;
+            if (heap[parent].key <= entry.key)
+                break;
+            heap[position] = heap[parent];
+            position = parent;
+        }
+        heap[position] = entry;
+    }
+
+    void sift_down(int position) {
+        const Entry entry = heap[position];
+        const int size = static_cast<int>(heap.size());
+        while (true) {
+            const int first_child = position * arity + 1;
+            if (first_child >= size)
+                break;
+            const int last_child = std::min(first_child + arity, size);
+            int best_child = first_child;
+            for (int child = first_child + 1; child < last_child; ++child) {
+                if (heap[child].key < heap[best_child].key)
+                    best_child = child;
+            }
+            if (entry.key <= heap[best_child].key)
+                break;
+            heap[position] = heap[best_child];
+            position = best_child;
+        }
+        heap[position] = entry;
+    }
+};
+
+struct SearchSeed {
+    int vertex;
+    double distance = 0.0;
+};
+
+// Reusable Dijkstra engine over dense vertex indices. Buffers are allocated once per engine and only the
+// vertices touched by the previous run are reset, so repeated runs on the same graph do not allocate.
+class ShortestPaths final {
+public:
+    static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+    explicit ShortestPaths(const GraphData& graph_data);
+
+    void run(const int source, const int target = -1) {
+        const SearchSeed seed{source};
+        run(std::span(&seed, 1), [target](const int vertex) { return vertex != target; });
+    }
+
+    // Multi-source run: every seed starts with its own initial distance. `on_settle(vertex)` is called once per
+    // settled vertex in non-decreasing distance order and may return false to stop the search early.
+    template <typename OnSettle>
+    void run(std::span<const SearchSeed> seeds, OnSettle&& on_settle);
+
+    double distance(const int vertex) const { return labels[vertex].dist; }
+
+    bool reached(const int vertex) const { return labels[vertex].dist != infinity; }
+
+    // Vertices from the seed that reached `vertex` up to `vertex` itself, or empty if it is unreachable.
+    std::vector<int> path_to(int vertex) const;
+
+private:
+    const GraphData& graph_data;
+    // dist/pred share one 16-byte slot so a relaxation touches a single cache line.
+    struct Label {
+        double dist = infinity;
+        int pred = -1;
+    };
+
+    std::vector<Label> labels;
+    std::vector<int> touched;
+    DaryHeap heap;
+
+    void reset();
+
+    void relax(const int vertex, const double length, const int from) {
+        auto& label = labels[vertex];
+        if (length >= label.dist)
+            return;
+        if (label.dist == infinity)
+            touched.push_back(vertex);
+        label = {length, from};
+        heap.push(vertex, length);
+    }
+};
+
+// How a fast travel route leaves its start: teleporting to the first stop costs one move, walking there costs the walk,
+// and the cheaper of the two is taken. Every fast travel solver charges the start through this class.
+class FastTravelStart final {
+public:
+    // `start_vertex` -1 means the route may begin anywhere for free.
+    FastTravelStart(const GraphData& graph_data, int start_vertex);
+
+    double cost(int vertex) const;
+
+    // Vertices from the start up to `vertex` at cost(vertex), or just `vertex` without a start.
+    std::vector<int> path_to(int vertex) const;
+
+private:
+    const int start_vertex;
+    ShortestPaths walks;
+};
+
+template <typename OnSettle>
+void ShortestPaths::run(const std::span<const SearchSeed> seeds, OnSettle&& on_settle) {
+    reset();
+    for (const auto& seed : seeds) {
+        relax(seed.vertex, seed.distance, -1);
+    }
+    while (!heap.empty()) {
+        const auto [key, current] = heap.pop();
+        if (key > labels[current].dist)
+            continue;
+        if (!on_settle(current)) {
+            heap.clear();
+            return;
+        }
+        const double length = labels[current].dist;
+        const auto& graph = graph_data.graph;
+        for (int edge = graph.edge_begin(current), edge_end = graph.edge_end(current); edge < edge_end; ++edge) {
+            relax(graph.targets[edge], length + graph.weights[edge], current);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "distance_oracle.hpp"
+#include "fast_travel_solver.hpp"
+#include "parser.hpp"
+#include "path_store.hpp"
+#include "quest_optimizer_x.hpp"
+
+struct SolveQuery {
+    // Indices into GraphData::quest_lines, all quest lines when empty.
+    std::vector<int> quest_lines;
+    // Start vertex, the map's own start when unset and no start at all when -1.
+    std::optional<int> start_index;
+    // Stops already completed on each selected quest line, none when empty.
+    std::vector<int> quest_positions;
+    // Route answered before the quest positions advanced. Its remaining suffix is only an incumbent that bounds the
+    // new heuristic search: no frontier survives between queries, so every query searches from scratch, and exact
+    // queries ignore it. The distance oracles are the only state reused across queries.
+    std::vector<int> previous_path;
+    unsigned num_threads = std::thread::hardware_concurrency();
+    unsigned max_queue_size = 100000;
+    double error_afford = 1.05;
+    unsigned depth_of_search = 1;
+    // Fast travel maps only: states kept per layer by the FastTravelSolver.
+    unsigned beam_width = FastTravelSolver::default_beam_width;
+    bool exact = false;
+    // Run a PortfolioSolver instead of one QuestOptimizer.
+    bool portfolio = false;
+    // Queue search only: search in reproducible rounds, see QuestOptimizer::set_deterministic.
+    bool deterministic = false;
+    size_t exact_memory_bytes = size_t{1} << 30;
+    // Budgets of the heuristic search; the exact solver is bounded by `exact_memory_bytes` only.
+    SearchLimits limits;
+    // serve() only: also answer with a line for every improving route found during the search.
+    bool stream = false;
+};
+
+struct SolveResult {
+    Path path;
+    bool proven_optimal = false;
+    double elapsed_ms = 0.0;
+};
+
+// Long-lived solver for one map. The graph is loaded once and distance oracles are kept per start vertex, so a
+// query only pays for the search itself. Queries may come from several threads; each runs its own search.
+class SolverService final {
+public:
+    explicit SolverService(GraphData graph_data, unsigned num_threads = std::thread::hardware_concurrency());
+
+    const GraphData& graph() const { return graph_data; }
+
+    SolveResult solve(const SolveQuery& query, const ImprovementCallback& on_improvement = {});
+
+    // Answers JSON-lines requests from `in` on `out` until end of input, one response line per request line.
+    // Request fields mirror SolveQuery plus an optional "id" that is echoed back; unset fields take `defaults`.
+    void serve(std::istream& in, std::ostream& out, const SolveQuery& defaults);
+
+private:
+    static constexpr size_t max_cached_oracles = 16;
+
+    // An oracle is built by the first query that needs it, outside the cache lock; other queries for the same start
+    // wait on its future. `last_use` orders the entries for least recently used eviction.
+    struct CachedOracle {
+        std::shared_future<std::shared_ptr<const DistanceOracle>> oracle;
+        std::uint64_t generation;
+        std::uint64_t last_use;
+    };
+
+    const GraphData graph_data;
+    const unsigned num_threads;
+    std::mutex oracle_mutex;
+    std::map<int, CachedOracle> oracles;
+    std::uint64_t oracle_clock = 0;
+
+    // Oracle over every quest stop of the map plus `start_index`.
+    std::shared_ptr<const DistanceOracle> oracle_for(int start_index);
+
+    GraphData query_graph(const SolveQuery& query) const;
+};
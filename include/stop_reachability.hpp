@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+class InfeasibleInstance final : public std::runtime_error {
+public:
+    explicit InfeasibleInstance(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+// Strongly connected component analysis of a walking map. A route can never return to a component it has left, so
+// the components holding quest stops and the start must lie on one chain of the condensation, and the route visits
+// them in chain order. Each stop gets the rank of its component along that chain: a route must finish every stop of
+// one rank before it moves on to the next, and an instance with no such chain is infeasible.
+class StopReachability final {
+public:
+    explicit StopReachability(const GraphData& graph_data);
+
+    bool feasible() const { return problem.empty(); }
+
+    // Why no route completes every quest line, empty when one does.
+    const std::string& infeasibility() const { return problem; }
+
+    // Throws InfeasibleInstance when no route completes every quest line.
+    void require_feasible() const;
+
+    // Chain position of the component of a quest stop or the start vertex.
+    int rank(const int stop) const { return component_rank[component[stop]]; }
+
+    int rank_count() const { return ranks; }
+
+    // Rank every route has to start its quest stops with.
+    int first_quest_rank() const { return first_rank; }
+
+private:
+    std::vector<int> component;
+    std::vector<int> component_rank;
+    int ranks = 0;
+    int first_rank = 0;
+    std::string problem;
+};
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <atomic>
+
+#include "distance_oracle.hpp"
+
+std::vector<int> DistanceOracle::quest_stops(const GraphData& graph_data) {
+    std::vector<int> stops;
+    for (const auto& quest_line : graph_data.quest_lines) {
+        stops.insert(stops.end(), quest_line.vertexes.begin(), quest_line.vertexes.end());
+    }
+    if (graph_data.start_index >= 0 && graph_data.start_index < graph_data.vertex_count) {
+        stops.push_back(graph_data.start_index);
+    }
+    return stops;
+}
+
+DistanceOracle::DistanceOracle(const GraphData& graph_data, const unsigned num_threads)
+    : DistanceOracle(graph_data, quest_stops(graph_data), num_threads) {}
+
+DistanceOracle::DistanceOracle(const GraphData& graph_data, std::vector<int> stops, const unsigned num_threads)
+    : graph_data(graph_data),
+      stop_vertexes(std::move(stops)),
+      vertex_to_stop(graph_data.vertex_count, -1) {
+    std::ranges::sort(stop_vertexes);
+    const auto [first, last] = std::ranges::unique(stop_vertexes);
+    stop_vertexes.erase(first, last);
+    for (int i = 0; i < stop_count(); ++i) {
+        vertex_to_stop[stop_vertexes[i]] = i;
+    }
+
+    distances.assign(stop_vertexes.size() * stop_vertexes.size(), infinity);
+    std::atomic<int> next_row{0};
+    const auto worker = [&] {
+        ShortestPaths engine(graph_data);
+        for (int row = next_row.fetch_add(1, std::memory_order::relaxed); row < stop_count();
+             row = next_row.fetch_add(1, std::memory_order::relaxed)) {
+            fill_row(row, engine);
+        }
+    };
+    const unsigned worker_count = std::clamp(num_threads, 1u, static_cast<unsigned>(std::max(stop_count(), 1)));
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count - 1);
+    for (unsigned i = 1; i < worker_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void DistanceOracle::fill_row(const int from_stop, ShortestPaths& engine) {
+    const SearchSeed seed{stop_vertexes[from_stop]};
+    int remaining_stops = stop_count();
+    const auto row = distances.begin() + static_cast<ptrdiff_t>(from_stop) * stop_count();
+    engine.run(std::span(&seed, 1), [&](const int vertex) {
+        if (const int to_stop = vertex_to_stop[vertex]; to_stop != -1) {
+            row[to_stop] = engine.distance(vertex);
+            --remaining_stops;
+        }
+        return remaining_stops > 0;
+    });
+}
+
+std::vector<int> DistanceOracle::unpack(ShortestPaths& engine, const int from_vertex, const int to_vertex) {
+    if (from_vertex == to_vertex)
+        return {};
+    engine.run(from_vertex, to_vertex);
+    auto route = engine.path_to(to_vertex);
+    if (!route.empty())
+        route.erase(route.begin());
+    return route;
+}
+
+std::vector<int> DistanceOracle::expand(const std::vector<int>& stop_route) const {
+    std::vector<int> route;
+    if (stop_route.empty())
+        return route;
+    ShortestPaths engine(graph_data);
+    route.push_back(stop_route.front());
+    for (size_t i = 1; i < stop_route.size(); ++i) {
+        const auto segment = unpack(engine, stop_route[i - 1], stop_route[i]);
+        route.insert(route.end(), segment.begin(), segment.end());
+    }
+    return route;
+}
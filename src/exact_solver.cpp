@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "exact_solver.hpp"
+#include "memory_usage.hpp"
+#include "shortest_paths.hpp"
+
+namespace {
+constexpr std::uint64_t no_parent = std::numeric_limits<std::uint64_t>::max();
+constexpr size_t lock_stripes = 1024;
+
+struct ActiveLine {
+    const std::vector<int>* vertexes;
+    size_t offset;
+    size_t remaining;
+    std::uint64_t stride;
+};
+
+struct Layout {
+    std::vector<ActiveLine> lines;
+    std::uint64_t progress_count = 1;
+    bool overflow = false;
+};
+
+Layout make_layout(const std::vector<QuestLine>& quest_lines, const std::vector<size_t>& initial_positions) {
+    Layout layout;
+    for (size_t quest_id = 0; quest_id < quest_lines.size(); ++quest_id) {
+        const auto& vertexes = quest_lines[quest_id].vertexes;
+        const size_t offset = std::min(initial_positions[quest_id], vertexes.size());
+        const size_t remaining = vertexes.size() - offset;
+        if (remaining == 0)
+            continue;
+        if (layout.progress_count > std::numeric_limits<std::uint64_t>::max() / (remaining + 1)) {
+            layout.overflow = true;
+            return layout;
+        }
+        layout.lines.push_back({&vertexes, offset, remaining, layout.progress_count});
+        layout.progress_count *= remaining + 1;
+    }
+    return layout;
+}
+
+void decode(const Layout& layout, const std::uint64_t progress, std::vector<size_t>& digits) {
+    for (size_t i = 0; i < layout.lines.size(); ++i) {
+        digits[i] = progress / layout.lines[i].stride % (layout.lines[i].remaining + 1);
+    }
+}
+
+int next_vertex(const ActiveLine& line, const size_t digit) { return (*line.vertexes)[line.offset + digit]; }
+
+// Moves to `vertex` from `progress`, advancing every line waiting on it. Returns the new progress index and the
+// first advanced line, which identifies the last visited stop in the table.
+std::pair<std::uint64_t, size_t> arrive(
+    const Layout& layout,
+    const std::vector<size_t>& digits,
+    std::uint64_t progress,
+    const int vertex
+) {
+    size_t first_line = layout.lines.size();
+    for (size_t i = 0; i < layout.lines.size(); ++i) {
+        const auto& line = layout.lines[i];
+        if (digits[i] < line.remaining && next_vertex(line, digits[i]) == vertex) {
+            progress += line.stride;
+            first_line = std::min(first_line, i);
+        }
+    }
+    return {progress, first_line};
+}
+
+template <typename Body>
+void parallel_for(const size_t count, const unsigned num_threads, Body&& body) {
+    std::atomic<size_t> next{0};
+    const auto worker = [&] {
+        std::vector<size_t> digits;
+        for (size_t i = next.fetch_add(1, std::memory_order::relaxed); i < count;
+             i = next.fetch_add(1, std::memory_order::relaxed)) {
+            body(i, digits);
+        }
+    };
+    const auto worker_count = static_cast<unsigned>(std::clamp<size_t>(num_threads, 1, std::max<size_t>(count, 1)));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < worker_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+} // namespace
+
+ExactSolver::ExactSolver(
+    const GraphData& graph_data,
+    const DistanceOracle* oracle,
+    const unsigned num_threads,
+    const size_t max_table_bytes
+)
+    : graph_data(graph_data),
+      oracle(oracle),
+      num_threads(num_threads),
+      max_table_bytes(max_table_bytes) {
+    if (oracle == nullptr && !graph_data.fast_travel)
+        throw std::invalid_argument("The exact solver needs a distance oracle on maps without fast travel");
+}
+
+size_t ExactSolver::table_bytes(const std::vector<size_t>& initial_positions) const {
+    const auto layout = make_layout(graph_data.quest_lines, initial_positions);
+    constexpr size_t entry_bytes = sizeof(double) + sizeof(std::uint64_t);
+    const size_t max_size = std::numeric_limits<size_t>::max();
+    if (layout.overflow || layout.progress_count > max_size / entry_bytes / std::max<size_t>(layout.lines.size(), 1))
+        return max_size;
+    return layout.progress_count * (layout.lines.size() * entry_bytes + sizeof(std::uint64_t));
+}
+
+Path ExactSolver::solve() const {
+    return solve(graph_data.start_index, std::vector<size_t>(graph_data.quest_lines.size(), 0));
+}
+
+Path ExactSolver::solve(const int start_vertex, const std::vector<size_t>& initial_positions) const {
+    const auto deadline = std::chrono::steady_clock::now() + limits.time_budget;
+    const size_t table_budget =
+        limits.max_rss_bytes > 0 ? std::min(max_table_bytes, limits.max_rss_bytes) : max_table_bytes;
+    if (const size_t bytes = table_bytes(initial_positions); bytes > table_budget) {
+        throw std::length_error(
+            "Exact solver needs " + std::to_string(bytes >> 20) + " MiB of table, budget is " +
+            std::to_string(table_budget >> 20) + " MiB"
+        );
+    }
+    const auto layout = make_layout(graph_data.quest_lines, initial_positions);
+    const size_t line_count = layout.lines.size();
+    if (line_count == 0)
+        return Path{start_vertex == -1 ? std::vector<int>{} : std::vector{start_vertex}, 0.0};
+
+    const bool fast_travel = graph_data.fast_travel;
+    std::optional<FastTravelStart> fast_travel_start;
+    std::vector<double> start_costs;
+    if (fast_travel) {
+        fast_travel_start.emplace(graph_data, start_vertex);
+    } else if (start_vertex != -1) {
+        ShortestPaths engine(graph_data);
+        engine.run(start_vertex);
+        start_costs.resize(graph_data.vertex_count);
+        for (int vertex = 0; vertex < graph_data.vertex_count; ++vertex) {
+            start_costs[vertex] = engine.distance(vertex);
+        }
+    }
+    const auto start_cost = [&](const int vertex) {
+        if (fast_travel)
+            return fast_travel_start->cost(vertex);
+        if (start_vertex == -1)
+            return 0.0;
+        return start_costs[vertex];
+    };
+    const auto move_cost = [&](const int from, const int to) { return fast_travel ? 1.0 : oracle->distance(from, to); };
+
+    const std::uint64_t progress_count = layout.progress_count;
+    std::vector lengths(progress_count * line_count, DistanceOracle::infinity);
+    std::vector parents(progress_count * line_count, no_parent);
+    std::array<std::mutex, lock_stripes> stripes;
+    const auto relax = [&](const std::uint64_t entry, const double length, const std::uint64_t parent) {
+        const std::scoped_lock lock(stripes[entry % lock_stripes]);
+        if (length < lengths[entry]) {
+            lengths[entry] = length;
+            parents[entry] = parent;
+        }
+    };
+
+    size_t total_stops = 0;
+    for (const auto& line : layout.lines) {
+        total_stops += line.remaining;
+    }
+    std::vector<std::vector<std::uint64_t>> layers(total_stops + 1);
+    {
+        std::vector<size_t> digits(line_count);
+        for (std::uint64_t progress = 0; progress < progress_count; ++progress) {
+            decode(layout, progress, digits);
+            size_t completed = 0;
+            for (const size_t digit : digits) {
+                completed += digit;
+            }
+            layers[completed].push_back(progress);
+        }
+    }
+
+    {
+        const std::vector<size_t> digits(line_count, 0);
+        for (const auto& line : layout.lines) {
+            const int vertex = next_vertex(line, 0);
+            const double cost = start_cost(vertex);
+            if (cost == DistanceOracle::infinity)
+                continue;
+            const auto [next_progress, last_line] = arrive(layout, digits, 0, vertex);
+            relax(next_progress * line_count + last_line, cost, no_parent);
+        }
+    }
+
+    for (size_t completed = 1; completed < total_stops; ++completed) {
+        if (limits.time_budget.count() > 0 && std::chrono::steady_clock::now() >= deadline)
+            throw std::runtime_error("Time budget exhausted before the exact solver finished");
+        if (limits.max_rss_bytes > 0 && resident_set_bytes() > limits.max_rss_bytes)
+            throw std::runtime_error("Memory budget exhausted before the exact solver finished");
+        const auto& layer = layers[completed];
+        parallel_for(layer.size(), num_threads, [&](const size_t i, std::vector<size_t>& digits) {
+            const std::uint64_t progress = layer[i];
+            digits.resize(line_count);
+            decode(layout, progress, digits);
+            for (size_t last = 0; last < line_count; ++last) {
+                const std::uint64_t entry = progress * line_count + last;
+                const double length = lengths[entry];
+                if (length == DistanceOracle::infinity)
+                    continue;
+                const int from = next_vertex(layout.lines[last], digits[last] - 1);
+                for (size_t line = 0; line < line_count; ++line) {
+                    if (digits[line] == layout.lines[line].remaining)
+                        continue;
+                    const int vertex = next_vertex(layout.lines[line], digits[line]);
+                    const double cost = move_cost(from, vertex);
+                    if (cost == DistanceOracle::infinity)
+                        continue;
+                    const auto [next_progress, last_line] = arrive(layout, digits, progress, vertex);
+                    relax(next_progress * line_count + last_line, length + cost, entry);
+                }
+            }
+        });
+    }
+
+    const std::uint64_t final_progress = progress_count - 1;
+    std::uint64_t best_entry = no_parent;
+    for (size_t last = 0; last < line_count; ++last) {
+        const std::uint64_t entry = final_progress * line_count + last;
+        if (best_entry == no_parent || lengths[entry] < lengths[best_entry])
+            best_entry = entry;
+    }
+    Path path{{}, lengths[best_entry]};
+    if (path.length == DistanceOracle::infinity)
+        return path;
+
+    std::vector<size_t> digits(line_count);
+    for (std::uint64_t entry = best_entry; entry != no_parent; entry = parents[entry]) {
+        decode(layout, entry / line_count, digits);
+        const size_t last = entry % line_count;
+        path.vertexes.push_back(next_vertex(layout.lines[last], digits[last] - 1));
+    }
+    std::ranges::reverse(path.vertexes);
+    if (fast_travel) {
+        auto route = fast_travel_start->path_to(path.vertexes.front());
+        route.insert(route.end(), std::next(path.vertexes.begin()), path.vertexes.end());
+        path.vertexes = std::move(route);
+    } else {
+        if (start_vertex != -1 && path.vertexes.front() != start_vertex)
+            path.vertexes.insert(path.vertexes.begin(), start_vertex);
+        path.vertexes = oracle->expand(path.vertexes);
+    }
+    return path;
+}
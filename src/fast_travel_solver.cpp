@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#include "fast_travel_solver.hpp"
+#include "local_search.hpp"
+#include "memory_usage.hpp"
+#include "quest_progress.hpp"
+#include "shortest_paths.hpp"
+
+namespace {
+// A state of one beam layer. `path` ends at the parent state until the state survives its layer and `vertex` is
+// appended. `bound` is the longest remaining quest line: every visit advances a line by at most one stop, so at least
+// that many visits are still ahead. `origin` packs the parent's index in its layer with `vertex`, which orders a layer
+// the way a single thread expands it.
+struct BeamState {
+    QuestProgress progress;
+    PathHandle path;
+    int vertex;
+    size_t remaining_stops;
+    size_t bound;
+    std::uint64_t origin = 0;
+};
+
+// Children of a layer expanded on several threads are sharded by the top bits of their progress hash, so shards can
+// be deduplicated independently.
+constexpr int layer_shard_bits = 4;
+constexpr size_t layer_shards = size_t{1} << layer_shard_bits;
+// Smallest slice of a layer worth expanding on its own thread.
+constexpr size_t min_states_per_worker = 128;
+
+size_t shard_of(const QuestProgress& progress) { return progress.hash >> (64 - layer_shard_bits); }
+
+// States of one layer shard in insertion order. A progress reached again keeps its first state.
+class LayerShard {
+public:
+    std::vector<BeamState> states;
+
+    void add(BeamState&& state) {
+        if (2 * states.size() >= slots.size()) {
+            slots.assign(2 * slots.size(), 0);
+            for (size_t i = 0; i < states.size(); ++i) {
+                size_t slot = states[i].progress.hash & (slots.size() - 1);
+                while (slots[slot] != 0) {
+                    slot = (slot + 1) & (slots.size() - 1);
+                }
+                slots[slot] = static_cast<std::uint32_t>(i + 1);
+            }
+        }
+        for (size_t slot = state.progress.hash & (slots.size() - 1);; slot = (slot + 1) & (slots.size() - 1)) {
+            if (slots[slot] == 0) {
+                slots[slot] = static_cast<std::uint32_t>(states.size() + 1);
+                states.push_back(std::move(state));
+                return;
+            }
+            if (states[slots[slot] - 1].progress == state.progress)
+                return;
+        }
+    }
+
+    void clear() {
+        states.clear();
+        std::ranges::fill(slots, 0);
+    }
+
+private:
+    // Open-addressing index of `states` by progress, slot value is the state index plus one.
+    std::vector<std::uint32_t> slots = std::vector<std::uint32_t>(64);
+};
+
+// Runs `body(worker)` for every worker in [0, worker_count), worker 0 on the calling thread.
+template <typename Body>
+void run_workers(const size_t worker_count, Body&& body) {
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < worker_count; ++worker) {
+        threads.emplace_back([&body, worker] { body(worker); });
+    }
+    body(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+} // namespace
+
+FastTravelSolver::FastTravelSolver(const GraphData& graph_data, const unsigned num_threads, const unsigned beam_width)
+    : graph_data(graph_data),
+      num_threads(std::max(num_threads, 1u)),
+      beam_width(std::max(beam_width, 1u)) {}
+
+bool FastTravelSolver::out_of_budget() const {
+    if (budget_exhausted.load(std::memory_order::relaxed))
+        return true;
+    const char* reason = nullptr;
+    if (limits.time_budget.count() > 0 && std::chrono::steady_clock::now() >= deadline)
+        reason = "Time budget exhausted";
+    else if (limits.max_rss_bytes > 0 && resident_set_bytes() > limits.max_rss_bytes)
+        reason = "Memory budget exhausted";
+    if (reason == nullptr)
+        return false;
+    if (!budget_exhausted.exchange(true, std::memory_order::relaxed))
+        std::cout << reason << ", finishing the beam search with one state per layer" << std::endl;
+    return true;
+}
+
+void FastTravelSolver::log_layer(const size_t visited_stops, const size_t beam_size) const {
+    const auto now = std::chrono::steady_clock::now();
+    const std::scoped_lock lock(log_mutex);
+    if (now < next_log)
+        return;
+    next_log = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(log_interval);
+    std::cout << "[Beam search] visited_stops: " << visited_stops << " beam_size: " << beam_size << std::endl;
+}
+
+FastTravelSolver::Coverage FastTravelSolver::cover(const int first_stop) const {
+    const auto& quest_lines = graph_data.quest_lines;
+    const ProgressLayout layout(quest_lines);
+    PathStore paths;
+    using WaitingLines = std::vector<std::pair<int, size_t>>;
+    const auto initial_state = [&] {
+        BeamState state{layout.initial(), PathStore::empty_path, -1, 0, 0};
+        for (const auto& quest_line : quest_lines) {
+            state.remaining_stops += quest_line.vertexes.size();
+            state.bound = std::max(state.bound, quest_line.vertexes.size());
+        }
+        return state;
+    };
+    // Children of `state`, one per waiting vertex. A child's bound drops only when the vertex advances every line
+    // that is currently the longest one. `waiting` is scratch space for the quest lines grouped by the vertex they
+    // wait on.
+    const auto expand = [&](const BeamState& state, WaitingLines& waiting, const auto& on_child) {
+        waiting.clear();
+        size_t longest_lines = 0;
+        for (size_t quest_id = 0; quest_id < quest_lines.size(); ++quest_id) {
+            const auto& vertexes = quest_lines[quest_id].vertexes;
+            const size_t position = layout.position(state.progress, quest_id);
+            if (position == vertexes.size())
+                continue;
+            waiting.emplace_back(vertexes[position], quest_id);
+            if (vertexes.size() - position == state.bound)
+                ++longest_lines;
+        }
+        std::ranges::sort(waiting);
+        for (size_t group = 0; group < waiting.size();) {
+            const int vertex = waiting[group].first;
+            BeamState child{state.progress, state.path, vertex, state.remaining_stops, state.bound};
+            size_t advanced_longest = 0;
+            for (; group < waiting.size() && waiting[group].first == vertex; ++group) {
+                const size_t quest_id = waiting[group].second;
+                const size_t remaining = quest_lines[quest_id].vertexes.size() -
+                                         layout.position(state.progress, quest_id);
+                layout.advance(child.progress, quest_id);
+                --child.remaining_stops;
+                if (remaining == state.bound)
+                    ++advanced_longest;
+            }
+            if (advanced_longest == longest_lines)
+                --child.bound;
+            on_child(std::move(child));
+        }
+    };
+
+    // Layer 0 is the initial progress without a visit, or the single state after the forced first stop.
+    std::vector layer{initial_state()};
+    std::vector<WaitingLines> waiting(num_threads);
+    if (first_stop != -1) {
+        expand(initial_state(), waiting.front(), [&](BeamState&& child) {
+            if (child.vertex == first_stop) {
+                child.path = paths.append(child.path, first_stop);
+                layer.front() = std::move(child);
+            }
+        });
+    }
+    bool exact = true;
+    size_t visited_stops = first_stop != -1 ? 1 : 0;
+    std::vector<BeamState> next_layer;
+    // Each worker deduplicates its slice of the layer into its own shards; worker 0's shards then absorb the others
+    // in worker order, so every shard keeps the first state of each progress in layer order. A single worker uses
+    // only shard 0.
+    std::vector<std::vector<LayerShard>> worker_shards(num_threads, std::vector<LayerShard>(layer_shards));
+    std::atomic<bool> cut_short{false};
+    while (true) {
+        for (const auto& state : layer) {
+            if (state.remaining_stops == 0)
+                return {paths.materialize(state.path), exact};
+        }
+        const size_t workers = std::clamp<size_t>(layer.size() / min_states_per_worker, 1, num_threads);
+        run_workers(workers, [&](const size_t worker) {
+            auto& shards = worker_shards[worker];
+            const size_t begin = layer.size() * worker / workers;
+            const size_t end = layer.size() * (worker + 1) / workers;
+            for (size_t i = begin; i < end; ++i) {
+                // wide layers take a while to expand, so an exhausted budget also cuts the current one short
+                if ((i - begin) % 1024 == 1023 && out_of_budget()) {
+                    cut_short.store(true, std::memory_order::relaxed);
+                    break;
+                }
+                expand(layer[i], waiting[worker], [&](BeamState&& child) {
+                    child.origin = static_cast<std::uint64_t>(i) << 32 | static_cast<std::uint32_t>(child.vertex);
+                    shards[workers > 1 ? shard_of(child.progress) : 0].add(std::move(child));
+                });
+            }
+        });
+        if (cut_short.exchange(false, std::memory_order::relaxed))
+            exact = false;
+        if (workers > 1) {
+            const size_t merge_workers = std::min(workers, layer_shards);
+            run_workers(merge_workers, [&](const size_t worker) {
+                for (size_t shard = worker; shard < layer_shards; shard += merge_workers) {
+                    for (size_t other = 1; other < workers; ++other) {
+                        for (auto& state : worker_shards[other][shard].states) {
+                            worker_shards.front()[shard].add(std::move(state));
+                        }
+                        worker_shards[other][shard].clear();
+                    }
+                }
+            });
+        }
+        next_layer.clear();
+        for (auto& shard : worker_shards.front()) {
+            std::ranges::move(shard.states, std::back_inserter(next_layer));
+            shard.clear();
+        }
+        // shards are in hash order; restoring expansion order makes the beam cut and the next layer independent of
+        // the thread count
+        if (workers > 1)
+            std::ranges::sort(next_layer, {}, &BeamState::origin);
+        if (const size_t width = out_of_budget() ? 1 : beam_width; next_layer.size() > width) {
+            exact = false;
+            const auto better = [](const BeamState& a, const BeamState& b) {
+                return a.bound != b.bound ? a.bound < b.bound : a.remaining_stops < b.remaining_stops;
+            };
+            std::ranges::nth_element(next_layer, next_layer.begin() + static_cast<long>(width), better);
+            next_layer.resize(width);
+        }
+        for (auto& state : next_layer) {
+            state.path = paths.append(state.path, state.vertex);
+        }
+        std::swap(layer, next_layer);
+        ++visited_stops;
+        if (log_interval.count() > 0)
+            log_layer(visited_stops, layer.size());
+    }
+}
+
+void FastTravelSolver::optimize() {
+    deadline = std::chrono::steady_clock::now() + limits.time_budget;
+    const int start_vertex = graph_data.start_index;
+    const auto offer = [&](Path route) {
+        if (route.length >= best_path.length)
+            return;
+        best_path = std::move(route);
+        if (improvement_callback)
+            improvement_callback(best_path);
+    };
+    const bool has_stops = std::ranges::any_of(graph_data.quest_lines, [](const QuestLine& quest_line) {
+        return !quest_line.vertexes.empty();
+    });
+    if (!has_stops) {
+        offer({start_vertex == -1 ? std::vector<int>{} : std::vector{start_vertex}, 0.0});
+        proven_optimal = true;
+        return;
+    }
+
+    const FastTravelStart start(graph_data, start_vertex);
+    const auto join = [&](const std::vector<int>& stops) {
+        Path route{start.path_to(stops.front()), start.cost(stops.front()) + static_cast<double>(stops.size() - 1)};
+        route.vertexes.insert(route.vertexes.end(), std::next(stops.begin()), stops.end());
+        return route;
+    };
+
+    std::cout << "Fast travel beam search, beam width " << beam_width << std::endl;
+    LocalSearch local_search(graph_data, nullptr);
+    local_search.set_budget(
+        limits.time_budget.count() > 0 ? deadline : std::chrono::steady_clock::time_point::max(),
+        limits.max_rss_bytes
+    );
+    const auto finish = [&](const Coverage& coverage) {
+        return join(coverage.exact ? coverage.stops : local_search.refine(coverage.stops).vertexes);
+    };
+    if (const auto stops = remaining_stop_route(graph_data.quest_lines, previous_route); !stops.empty())
+        offer(join(stops));
+    const auto free_coverage = cover(-1);
+    offer(finish(free_coverage));
+    proven_optimal = free_coverage.exact;
+
+    // A forced first stop only beats the free search when the start reaches it for less than one move.
+    std::vector<int> first_stops;
+    if (start_vertex != -1) {
+        for (const auto& quest_line : graph_data.quest_lines) {
+            if (!quest_line.vertexes.empty() && start.cost(quest_line.vertexes.front()) < 1.0)
+                first_stops.push_back(quest_line.vertexes.front());
+        }
+        std::ranges::sort(first_stops);
+        first_stops.erase(std::ranges::unique(first_stops).begin(), first_stops.end());
+    }
+    for (const int first_stop : first_stops) {
+        const auto coverage = cover(first_stop);
+        proven_optimal = proven_optimal && coverage.exact;
+        offer(finish(coverage));
+    }
+    if (proven_optimal)
+        std::cout << "Search space exhausted, path is optimal" << std::endl;
+}
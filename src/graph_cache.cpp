@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+
+#include "graph_cache.hpp"
+#include "mapped_file.hpp"
+#include "mapped_parser.hpp"
+
+namespace {
+constexpr char cache_magic[8] = {'Q', 'O', 'X', 'G', 'R', 'A', 'P', 'H'};
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+enum Flags : std::uint32_t { FastTravel = 1u << 0, Weighted = 1u << 1, Bidirectional = 1u << 2 };
+
+struct QuestLineRecord {
+    std::int32_t id;
+    std::uint32_t reserved;
+    std::uint64_t vertex_begin;
+    std::uint64_t vertex_end;
+    std::uint64_t name_begin;
+    std::uint64_t name_end;
+};
+
+enum Section : size_t {
+    Offsets,
+    Targets,
+    Weights,
+    NameOffsets,
+    NameBytes,
+    QuestLines,
+    QuestVertexes,
+    QuestNameBytes,
+    SectionCount
+};
+
+struct Header {
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint64_t source_hash;
+    std::uint32_t flags;
+    std::int32_t vertex_count;
+    std::int32_t start_index;
+    std::int32_t reserved;
+    std::uint64_t section_offset[SectionCount];
+    std::uint64_t section_size[SectionCount];
+};
+
+size_t align8(const size_t value) { return (value + 7) & ~size_t{7}; }
+
+class SectionWriter {
+public:
+    explicit SectionWriter(Header& header) : header(header) {}
+
+    template <typename T>
+    void add(const Section section, const std::span<const T> items) {
+        const size_t bytes = items.size_bytes();
+        header.section_offset[section] = buffer.size();
+        header.section_size[section] = bytes;
+        buffer.resize(align8(buffer.size() + bytes));
+        if (bytes > 0)
+            std::memcpy(buffer.data() + header.section_offset[section], items.data(), bytes);
+    }
+
+    const std::vector<char>& bytes() const { return buffer; }
+
+private:
+    Header& header;
+    std::vector<char> buffer = std::vector<char>(align8(sizeof(Header)));
+};
+
+template <typename T>
+std::optional<std::span<const T>> section_view(const std::string_view data, const Header& header, const Section section) {
+    const std::uint64_t offset = header.section_offset[section];
+    const std::uint64_t size = header.section_size[section];
+    if (offset % alignof(T) != 0 || size % sizeof(T) != 0 || offset > data.size() || size > data.size() - offset)
+        return std::nullopt;
+    return std::span(reinterpret_cast<const T*>(data.data() + offset), size / sizeof(T));
+}
+
+// Offsets start at 0, never decrease and end at `end`.
+template <typename T>
+bool valid_offsets(const std::span<const T> offsets, const size_t end) {
+    return !offsets.empty() && offsets.front() == 0 && std::ranges::is_sorted(offsets) &&
+           static_cast<size_t>(offsets.back()) == end;
+}
+
+bool valid_vertexes(const std::span<const int> vertexes, const int vertex_count) {
+    return std::ranges::all_of(vertexes, [&](const int vertex) { return vertex >= 0 && vertex < vertex_count; });
+}
+} // namespace
+
+std::uint64_t GraphCache::hash_file(const std::string& file_path) {
+    const MappedFile file(file_path);
+    const auto data = file.view();
+    std::uint64_t hash = 0xcbf29ce484222325ULL ^ data.size();
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data.data() + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < data.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void GraphCache::write(const std::string& cache_path, const GraphData& graph_data, const std::uint64_t source_hash) {
+    Header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.byte_order = byte_order_mark;
+    header.version = format_version;
+    header.source_hash = source_hash;
+    header.flags = (graph_data.fast_travel ? std::uint32_t{FastTravel} : 0) |
+                   (graph_data.weighted ? std::uint32_t{Weighted} : 0) |
+                   (graph_data.bidirectional ? std::uint32_t{Bidirectional} : 0);
+    header.vertex_count = graph_data.vertex_count;
+    header.start_index = graph_data.start_index;
+
+    std::vector<std::uint64_t> name_offsets{0};
+    std::string name_bytes;
+    for (const auto& name : graph_data.vertex_names) {
+        name_bytes += name;
+        name_offsets.push_back(name_bytes.size());
+    }
+    std::vector<QuestLineRecord> quest_records;
+    std::vector<int> quest_vertexes;
+    std::string quest_name_bytes;
+    for (const auto& quest_line : graph_data.quest_lines) {
+        QuestLineRecord record{quest_line.id, 0, quest_vertexes.size(), 0, quest_name_bytes.size(), 0};
+        quest_vertexes.insert(quest_vertexes.end(), quest_line.vertexes.begin(), quest_line.vertexes.end());
+        quest_name_bytes += quest_line.name;
+        record.vertex_end = quest_vertexes.size();
+        record.name_end = quest_name_bytes.size();
+        quest_records.push_back(record);
+    }
+
+    SectionWriter writer(header);
+    writer.add(Offsets, graph_data.graph.offsets);
+    writer.add(Targets, graph_data.graph.targets);
+    writer.add(Weights, graph_data.graph.weights);
+    writer.add(NameOffsets, std::span<const std::uint64_t>(name_offsets));
+    writer.add(NameBytes, std::span<const char>(name_bytes));
+    writer.add(QuestLines, std::span<const QuestLineRecord>(quest_records));
+    writer.add(QuestVertexes, std::span<const int>(quest_vertexes));
+    writer.add(QuestNameBytes, std::span<const char>(quest_name_bytes));
+
+    const std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("Unable to write graph cache: " + cache_path);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(writer.bytes().data() + sizeof(header), static_cast<std::streamsize>(writer.bytes().size() - sizeof(header)));
+        if (!out)
+            throw std::runtime_error("Unable to write graph cache: " + cache_path);
+    }
+    std::filesystem::rename(temp_path, cache_path);
+}
+
+std::optional<GraphData> GraphCache::read(const std::string& cache_path, const std::uint64_t source_hash) {
+    if (!std::filesystem::exists(cache_path))
+        return std::nullopt;
+    auto file = std::make_shared<const MappedFile>(cache_path);
+    const auto data = file->view();
+    if (data.size() < sizeof(Header))
+        return std::nullopt;
+    Header header{};
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.byte_order != byte_order_mark ||
+        header.version != format_version || header.source_hash != source_hash || header.vertex_count < 0)
+        return std::nullopt;
+
+    const auto offsets = section_view<int>(data, header, Offsets);
+    const auto targets = section_view<int>(data, header, Targets);
+    const auto weights = section_view<double>(data, header, Weights);
+    const auto name_offsets = section_view<std::uint64_t>(data, header, NameOffsets);
+    const auto name_bytes = section_view<char>(data, header, NameBytes);
+    const auto quest_records = section_view<QuestLineRecord>(data, header, QuestLines);
+    const auto quest_vertexes = section_view<int>(data, header, QuestVertexes);
+    const auto quest_name_bytes = section_view<char>(data, header, QuestNameBytes);
+    if (!offsets || !targets || !weights || !name_offsets || !name_bytes || !quest_records || !quest_vertexes ||
+        !quest_name_bytes)
+        return std::nullopt;
+    // the hash only proves the source is unchanged, a truncated or edited cache must still not be read out of bounds
+    const size_t vertex_count = header.vertex_count;
+    if (offsets->size() != vertex_count + 1 || !valid_offsets(*offsets, targets->size()) ||
+        targets->size() != weights->size() || !valid_vertexes(*targets, header.vertex_count) ||
+        name_offsets->size() != vertex_count + 1 || !valid_offsets(*name_offsets, name_bytes->size()) ||
+        !valid_vertexes(*quest_vertexes, header.vertex_count) ||
+        (header.start_index != -1 && (header.start_index < 0 || header.start_index >= header.vertex_count)))
+        return std::nullopt;
+
+    GraphData graph_data{};
+    graph_data.fast_travel = header.flags & FastTravel;
+    graph_data.weighted = header.flags & Weighted;
+    graph_data.bidirectional = header.flags & Bidirectional;
+    graph_data.vertex_count = header.vertex_count;
+    graph_data.start_index = header.start_index;
+    for (size_t i = 0; i + 1 < name_offsets->size(); ++i) {
+        graph_data.vertex_names.emplace_back(
+            name_bytes->data() + (*name_offsets)[i],
+            name_bytes->data() + (*name_offsets)[i + 1]
+        );
+    }
+    for (const auto& record : *quest_records) {
+        if (record.vertex_begin > record.vertex_end || record.vertex_end > quest_vertexes->size() ||
+            record.name_begin > record.name_end || record.name_end > quest_name_bytes->size())
+            return std::nullopt;
+        graph_data.quest_lines.push_back(
+            {record.id,
+             std::string(quest_name_bytes->data() + record.name_begin, quest_name_bytes->data() + record.name_end),
+             std::vector(quest_vertexes->begin() + record.vertex_begin, quest_vertexes->begin() + record.vertex_end)}
+        );
+    }
+    graph_data.stop_index = QuestStopIndex::build(graph_data.quest_lines, graph_data.vertex_count);
+    graph_data.graph = CsrGraph::view(*offsets, *targets, *weights, std::move(file));
+    return graph_data;
+}
+
+GraphData GraphCache::load_or_parse(
+    const std::string& source_path,
+    const std::string& cache_path,
+    const unsigned num_threads
+) {
+    const auto source_hash = hash_file(source_path);
+    if (auto cached = read(cache_path, source_hash)) {
+        std::cout << "Loaded graph cache " << cache_path << "\n";
+        return std::move(*cached);
+    }
+    auto graph_data = MappedParser::parse_file(source_path, num_threads);
+    write(cache_path, graph_data, source_hash);
+    std::cout << "Wrote graph cache " << cache_path << "\n";
+    return graph_data;
+}
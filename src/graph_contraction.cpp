@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <utility>
+
+#include "graph_contraction.hpp"
+
+namespace {
+struct Arc {
+    int to;
+    double weight;
+    int shortcut;
+};
+
+// Mutable adjacency used while contracting; `in` lists the sources of the arcs ending in a vertex.
+struct WorkGraph {
+    std::vector<std::vector<Arc>> out;
+    std::vector<std::vector<int>> in;
+
+    Arc* find_arc(const int from, const int to) {
+        const auto it = std::ranges::find(out[from], to, &Arc::to);
+        return it == out[from].end() ? nullptr : &*it;
+    }
+
+    void remove_vertex(const int vertex) {
+        for (const int from : in[vertex]) {
+            std::erase_if(out[from], [vertex](const Arc& arc) { return arc.to == vertex; });
+        }
+        for (const auto& arc : out[vertex]) {
+            std::erase(in[arc.to], vertex);
+        }
+        out[vertex].clear();
+        in[vertex].clear();
+    }
+};
+
+std::vector<char> reachable(const std::vector<int>& sources, const auto& next_vertexes, const int vertex_count) {
+    std::vector<char> seen(vertex_count, false);
+    std::vector<int> stack;
+    for (const int source : sources) {
+        if (!seen[source]) {
+            seen[source] = true;
+            stack.push_back(source);
+        }
+    }
+    while (!stack.empty()) {
+        const int vertex = stack.back();
+        stack.pop_back();
+        next_vertexes(vertex, [&](const int next) {
+            if (!seen[next]) {
+                seen[next] = true;
+                stack.push_back(next);
+            }
+        });
+    }
+    return seen;
+}
+} // namespace
+
+GraphContraction::GraphContraction(const GraphData& graph_data) {
+    const int vertex_count = graph_data.vertex_count;
+    const auto& graph = graph_data.graph;
+    std::vector<char> is_stop(vertex_count, false);
+    std::vector<int> stops;
+    for (const auto& quest_line : graph_data.quest_lines) {
+        stops.insert(stops.end(), quest_line.vertexes.begin(), quest_line.vertexes.end());
+    }
+    if (graph_data.start_index != -1)
+        stops.push_back(graph_data.start_index);
+    for (const int stop : stops) {
+        is_stop[stop] = true;
+    }
+
+    // A vertex can be on a route only if a stop reaches it and it reaches a stop.
+    std::vector<std::vector<int>> reverse(vertex_count);
+    for (int from = 0; from < vertex_count; ++from) {
+        for (int e = graph.edge_begin(from); e < graph.edge_end(from); ++e) {
+            reverse[graph.targets[e]].push_back(from);
+        }
+    }
+    const auto from_stops = reachable(stops, [&](const int vertex, const auto& visit) {
+        for (int e = graph.edge_begin(vertex); e < graph.edge_end(vertex); ++e) {
+            visit(graph.targets[e]);
+        }
+    }, vertex_count);
+    const auto to_stops = reachable(stops, [&](const int vertex, const auto& visit) {
+        for (const int from : reverse[vertex]) {
+            visit(from);
+        }
+    }, vertex_count);
+    reverse = {};
+    std::vector<char> removed(vertex_count);
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        removed[vertex] = !from_stops[vertex] || !to_stops[vertex];
+    }
+
+    WorkGraph work{std::vector<std::vector<Arc>>(vertex_count), std::vector<std::vector<int>>(vertex_count)};
+    for (int from = 0; from < vertex_count; ++from) {
+        for (int e = graph.edge_begin(from); e < graph.edge_end(from); ++e) {
+            const int to = graph.targets[e];
+            if (removed[from] || removed[to] || from == to)
+                continue;
+            if (Arc* arc = work.find_arc(from, to)) {
+                arc->weight = std::min(arc->weight, graph.weights[e]);
+            } else {
+                work.out[from].push_back({to, graph.weights[e], original_edge});
+                work.in[to].push_back(from);
+            }
+        }
+    }
+
+    // Contracting a vertex never raises the neighbour count of the others, so it can only enable its neighbours.
+    std::vector<int> pending;
+    for (int vertex = vertex_count - 1; vertex >= 0; --vertex) {
+        if (!removed[vertex] && !is_stop[vertex])
+            pending.push_back(vertex);
+    }
+    std::vector<int> neighbours;
+    while (!pending.empty()) {
+        const int vertex = pending.back();
+        pending.pop_back();
+        if (removed[vertex])
+            continue;
+        neighbours = work.in[vertex];
+        for (const auto& arc : work.out[vertex]) {
+            neighbours.push_back(arc.to);
+        }
+        std::ranges::sort(neighbours);
+        neighbours.erase(std::ranges::unique(neighbours).begin(), neighbours.end());
+        if (neighbours.size() > 2)
+            continue;
+        // a path entering and leaving through the same neighbour is a detour and needs no shortcut
+        for (const int from : work.in[vertex]) {
+            const Arc into = *work.find_arc(from, vertex);
+            for (const auto& out_arc : work.out[vertex]) {
+                if (out_arc.to == from)
+                    continue;
+                const double weight = into.weight + out_arc.weight;
+                Arc* existing = work.find_arc(from, out_arc.to);
+                if (existing != nullptr && existing->weight <= weight)
+                    continue;
+                const auto shortcut = static_cast<int>(shortcuts.size());
+                shortcuts.push_back({into.shortcut, vertex, out_arc.shortcut});
+                if (existing != nullptr) {
+                    *existing = {out_arc.to, weight, shortcut};
+                } else {
+                    work.out[from].push_back({out_arc.to, weight, shortcut});
+                    work.in[out_arc.to].push_back(from);
+                }
+            }
+        }
+        work.remove_vertex(vertex);
+        removed[vertex] = true;
+        for (const int neighbour : neighbours) {
+            if (!is_stop[neighbour])
+                pending.push_back(neighbour);
+        }
+    }
+
+    std::vector<int> reduced_vertex(vertex_count, -1);
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        if (!removed[vertex]) {
+            reduced_vertex[vertex] = static_cast<int>(original_vertexes.size());
+            original_vertexes.push_back(vertex);
+        }
+    }
+    std::vector<int> offsets{0};
+    std::vector<int> targets;
+    std::vector<double> weights;
+    for (const int vertex : original_vertexes) {
+        auto& arcs = work.out[vertex];
+        std::ranges::sort(arcs, {}, &Arc::to);
+        for (const auto& arc : arcs) {
+            targets.push_back(reduced_vertex[arc.to]);
+            weights.push_back(arc.weight);
+            edge_shortcuts.push_back(arc.shortcut);
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+
+    reduced_graph.graph = CsrGraph::from_arrays(std::move(offsets), std::move(targets), std::move(weights));
+    reduced_graph.fast_travel = graph_data.fast_travel;
+    reduced_graph.weighted = graph_data.weighted || !shortcuts.empty();
+    reduced_graph.bidirectional = graph_data.bidirectional;
+    reduced_graph.vertex_count = static_cast<int>(original_vertexes.size());
+    reduced_graph.start_index = graph_data.start_index == -1 ? -1 : reduced_vertex[graph_data.start_index];
+    for (const int vertex : original_vertexes) {
+        if (std::cmp_less(vertex, graph_data.vertex_names.size()))
+            reduced_graph.vertex_names.push_back(graph_data.vertex_names[vertex]);
+    }
+    reduced_graph.quest_lines = graph_data.quest_lines;
+    for (auto& quest_line : reduced_graph.quest_lines) {
+        for (int& vertex : quest_line.vertexes) {
+            vertex = reduced_vertex[vertex];
+        }
+    }
+    reduced_graph.stop_index = QuestStopIndex::build(reduced_graph.quest_lines, reduced_graph.vertex_count);
+}
+
+void GraphContraction::unpack(const int shortcut, std::vector<int>& vertexes) const {
+    // Items are shortcuts to unpack or complemented vertices to emit; long corridors make deep shortcut trees.
+    std::vector<int> items{shortcut};
+    while (!items.empty()) {
+        const int item = items.back();
+        items.pop_back();
+        if (item < 0) {
+            vertexes.push_back(~item);
+            continue;
+        }
+        const auto& [first, via, second] = shortcuts[item];
+        if (second != original_edge)
+            items.push_back(second);
+        items.push_back(~via);
+        if (first != original_edge)
+            items.push_back(first);
+    }
+}
+
+Path GraphContraction::expand(const Path& reduced_route) const {
+    Path route{{}, reduced_route.length};
+    const auto& graph = reduced_graph.graph;
+    for (size_t i = 0; i < reduced_route.vertexes.size(); ++i) {
+        const int vertex = reduced_route.vertexes[i];
+        if (i > 0) {
+            const int from = reduced_route.vertexes[i - 1];
+            const auto edges = graph.targets.subspan(graph.edge_begin(from), graph.out_degree(from));
+            if (const auto it = std::ranges::lower_bound(edges, vertex); it != edges.end() && *it == vertex) {
+                if (const int shortcut = edge_shortcuts[graph.edge_begin(from) + (it - edges.begin())];
+                    shortcut != original_edge)
+                    unpack(shortcut, route.vertexes);
+            }
+        }
+        route.vertexes.push_back(original_vertexes[vertex]);
+    }
+    return route;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+
+#include "local_search.hpp"
+#include "memory_usage.hpp"
+
+namespace {
+// Unconstrained route end, and the route start when it is not fixed: moving to or from it is free.
+constexpr int free_vertex = -1;
+constexpr double improvement_epsilon = 1e-9;
+constexpr size_t max_or_opt_segment = 3;
+constexpr size_t max_improving_moves = 100000;
+// Reading the resident set size is a file read, so it is only checked every this many moves.
+constexpr size_t rss_check_interval = 64;
+} // namespace
+
+LocalSearch::LocalSearch(const GraphData& graph_data, const DistanceOracle* oracle)
+    : graph_data(graph_data),
+      oracle(oracle),
+      start_vertex(oracle != nullptr ? graph_data.start_index : free_vertex) {
+    for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
+        const auto& vertexes = graph_data.quest_lines[quest_id].vertexes;
+        first_task_of_quest.push_back(task_vertex.size());
+        for (size_t position = 0; position < vertexes.size(); ++position) {
+            const auto task = static_cast<int>(task_vertex.size());
+            task_vertex.push_back(vertexes[position]);
+            task_quest.push_back(static_cast<int>(quest_id));
+            previous_task.push_back(position > 0 ? task - 1 : -1);
+            next_task.push_back(position + 1 < vertexes.size() ? task + 1 : -1);
+        }
+    }
+}
+
+double LocalSearch::distance(const int from_vertex, const int to_vertex) const {
+    if (from_vertex == free_vertex || to_vertex == free_vertex || from_vertex == to_vertex)
+        return 0.0;
+    return oracle != nullptr ? oracle->distance(from_vertex, to_vertex) : 1.0;
+}
+
+double LocalSearch::route_cost(const std::vector<int>& stop_route) const {
+    if (stop_route.empty())
+        return 0.0;
+    if (oracle == nullptr)
+        return static_cast<double>(stop_route.size() - 1);
+    double cost = start_vertex == free_vertex ? 0.0 : oracle->distance(start_vertex, stop_route.front());
+    for (size_t i = 1; i < stop_route.size(); ++i) {
+        cost += oracle->distance(stop_route[i - 1], stop_route[i]);
+    }
+    return cost;
+}
+
+std::vector<int> LocalSearch::unroll(const std::vector<int>& stop_route) const {
+    std::vector<size_t> positions(graph_data.quest_lines.size(), 0);
+    std::vector<int> task_order;
+    for (const int vertex : stop_route) {
+        for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
+            const auto& vertexes = graph_data.quest_lines[quest_id].vertexes;
+            if (positions[quest_id] < vertexes.size() && vertexes[positions[quest_id]] == vertex) {
+                task_order.push_back(static_cast<int>(first_task_of_quest[quest_id] + positions[quest_id]));
+                ++positions[quest_id];
+            }
+        }
+    }
+    return task_order;
+}
+
+std::vector<int> LocalSearch::roll_up(const std::vector<int>& task_order) const {
+    std::vector<size_t> positions(graph_data.quest_lines.size(), 0);
+    std::vector<int> stop_route;
+    for (const int task : task_order) {
+        const auto quest_id = static_cast<size_t>(task_quest[task]);
+        // already done on an earlier visit of the same vertex
+        if (positions[quest_id] > task - first_task_of_quest[quest_id])
+            continue;
+        const int vertex = task_vertex[task];
+        stop_route.push_back(vertex);
+        for (size_t other = 0; other < graph_data.quest_lines.size(); ++other) {
+            const auto& vertexes = graph_data.quest_lines[other].vertexes;
+            if (positions[other] < vertexes.size() && vertexes[positions[other]] == vertex)
+                ++positions[other];
+        }
+    }
+    return stop_route;
+}
+
+Path LocalSearch::refine(const std::vector<int>& stop_route) const {
+    Path best{stop_route, route_cost(stop_route)};
+    auto task_order = unroll(stop_route);
+    const size_t n = task_order.size();
+    if (n != task_vertex.size() || n < 2)
+        return best;
+
+    // Route positions are 1-based: position 0 is the start and position n + 1 the open end.
+    std::vector<int> vertex(n + 2, free_vertex);
+    std::vector<size_t> position_of_task(n);
+    std::vector<double> forward(n + 1, 0.0);
+    std::vector<double> backward(n + 1, 0.0);
+    const auto cost = [&](const size_t from, const size_t to) { return distance(vertex[from], vertex[to]); };
+    const auto sync = [&] {
+        vertex[0] = start_vertex;
+        for (size_t p = 1; p <= n; ++p) {
+            vertex[p] = task_vertex[task_order[p - 1]];
+            position_of_task[task_order[p - 1]] = p;
+        }
+        for (size_t p = 2; p <= n; ++p) {
+            forward[p] = forward[p - 1] + cost(p - 1, p);
+            backward[p] = backward[p - 1] + cost(p, p - 1);
+        }
+    };
+    // Positions of the previous and next stop of the same quest line, 0 and n + 1 when there is none.
+    const auto previous_position = [&](const size_t p) -> size_t {
+        const int task = previous_task[task_order[p - 1]];
+        return task == -1 ? 0 : position_of_task[task];
+    };
+    const auto next_position = [&](const size_t p) -> size_t {
+        const int task = next_task[task_order[p - 1]];
+        return task == -1 ? n + 1 : position_of_task[task];
+    };
+
+    // Moves the segment [i, e] between positions j and j + 1.
+    const auto try_or_opt = [&] {
+        for (size_t length = 1; length <= max_or_opt_segment; ++length) {
+            for (size_t i = 1; i + length - 1 <= n; ++i) {
+                const size_t e = i + length - 1;
+                size_t latest_previous = 0;
+                size_t earliest_next = n + 1;
+                for (size_t p = i; p <= e; ++p) {
+                    if (const size_t previous = previous_position(p); previous < i)
+                        latest_previous = std::max(latest_previous, previous);
+                    if (const size_t next = next_position(p); next > e)
+                        earliest_next = std::min(earliest_next, next);
+                }
+                const double removal_gain = cost(i - 1, i) + cost(e, e + 1) - cost(i - 1, e + 1);
+                const auto gain = [&](const size_t j) {
+                    return removal_gain - (cost(j, i) + cost(e, j + 1) - cost(j, j + 1));
+                };
+                for (size_t j = latest_previous; j + 2 <= i; ++j) {
+                    if (gain(j) > improvement_epsilon) {
+                        std::rotate(task_order.begin() + j, task_order.begin() + i - 1, task_order.begin() + e);
+                        return true;
+                    }
+                }
+                for (size_t j = e + 1; j < earliest_next && j <= n; ++j) {
+                    if (gain(j) > improvement_epsilon) {
+                        std::rotate(task_order.begin() + i - 1, task_order.begin() + e, task_order.begin() + j);
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    };
+
+    const auto try_swap = [&] {
+        for (size_t i = 1; i <= n; ++i) {
+            for (size_t j = i + 2; j <= n && next_position(i) > j; ++j) {
+                if (previous_position(j) >= i)
+                    continue;
+                const double gain = cost(i - 1, i) + cost(i, i + 1) + cost(j - 1, j) + cost(j, j + 1) -
+                                    cost(i - 1, j) - cost(j, i + 1) - cost(j - 1, i) - cost(i, j + 1);
+                if (gain > improvement_epsilon) {
+                    std::swap(task_order[i - 1], task_order[j - 1]);
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // Reverses [i, j]; the reversed inner edges are priced with prefix sums of backward distances.
+    const auto try_two_opt = [&] {
+        for (size_t i = 1; i < n; ++i) {
+            size_t earliest_next = next_position(i);
+            for (size_t j = i + 1; j <= n; ++j) {
+                earliest_next = std::min(earliest_next, next_position(j));
+                if (earliest_next <= j)
+                    break;
+                const double gain = cost(i - 1, i) + cost(j, j + 1) - cost(i - 1, j) - cost(i, j + 1) +
+                                    (forward[j] - forward[i]) - (backward[j] - backward[i]);
+                if (gain > improvement_epsilon) {
+                    std::reverse(task_order.begin() + i - 1, task_order.begin() + j);
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    const auto out_of_budget = [&](const size_t moves) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return true;
+        return max_rss_bytes > 0 && moves % rss_check_interval == 0 && resident_set_bytes() > max_rss_bytes;
+    };
+
+    sync();
+    for (size_t moves = 0; moves < max_improving_moves && !out_of_budget(moves) &&
+                           (try_or_opt() || try_swap() || try_two_opt());
+         ++moves) {
+        sync();
+    }
+
+    auto refined_route = roll_up(task_order);
+    if (const double refined_cost = route_cost(refined_route); refined_cost < best.length)
+        best = Path{std::move(refined_route), refined_cost};
+    return best;
+}
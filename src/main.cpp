@@ -1,6 +1,19 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 
+#include "exact_solver.hpp"
+#include "fast_travel_solver.hpp"
+#include "graph_cache.hpp"
+#include "graph_contraction.hpp"
+#include "mapped_parser.hpp"
+#include "portfolio_solver.hpp"
 #include "quest_optimizer_x.hpp"
+#include "solver_service.hpp"
 
 namespace {
 std::unordered_map<std::string, std::string> parse_args(const int argc, char** argv) {
@@ -18,25 +31,154 @@ std::unordered_map<std::string, std::string> parse_args(const int argc, char** a
     }
     return args;
 }
+
+SearchLimits search_limits(std::unordered_map<std::string, std::string>& args) {
+    SearchLimits limits;
+    if (args.contains("--time_limit_ms"))
+        limits.time_budget = std::chrono::milliseconds(std::stoll(args["--time_limit_ms"]));
+    if (args.contains("--max_memory_mb"))
+        limits.max_rss_bytes = std::stoull(args["--max_memory_mb"]) << 20;
+    return limits;
+}
+
+// Throws for the first of `options` that was given, since `solver` would silently ignore it.
+void reject_options(
+    const std::unordered_map<std::string, std::string>& args,
+    const std::initializer_list<std::string> options,
+    const std::string& solver
+) {
+    for (const auto& option : options) {
+        if (args.contains(option))
+            throw std::invalid_argument(option + " is not supported by " + solver);
+    }
+}
+
+void print_improvement(const Path& path) { std::cout << "[Improvement] length: " << path.length << std::endl; }
 } // namespace
 
 int main(const int argc, char** argv) {
     try {
         auto args = parse_args(argc, argv);
+        // in service mode responses own stdout and progress logs go to stderr
+        std::ostream responses(std::cout.rdbuf());
+        if (args.contains("--serve"))
+            std::cout.rdbuf(std::cerr.rdbuf());
         const std::string file = args["--file"];
-        const auto graph_data = Parser::parse_file(file);
-        QuestOptimizer optimizer(
-            graph_data,
-            std::stoi(args["--num_threads"]),
-            std::stoi(args["--max_queue_size"]),
-            std::stod(args["--error_afford"]),
-            std::stoi(args["--depth_of_search"]),
-            std::stof(args["--log_interval_seconds"])
-        );
-        optimizer.optimize();
+        const unsigned num_threads = std::stoi(args["--num_threads"]);
+        const auto graph_data = args.contains("--graph_cache")
+                                    ? GraphCache::load_or_parse(file, args["--graph_cache"], num_threads)
+                                    : MappedParser::parse_file(file, num_threads);
+        if (args.contains("--serve")) {
+            SolveQuery defaults;
+            defaults.num_threads = num_threads;
+            if (args.contains("--max_queue_size"))
+                defaults.max_queue_size = std::stoi(args["--max_queue_size"]);
+            if (args.contains("--error_afford"))
+                defaults.error_afford = std::stod(args["--error_afford"]);
+            if (args.contains("--depth_of_search"))
+                defaults.depth_of_search = std::stoi(args["--depth_of_search"]);
+            if (args.contains("--beam_width"))
+                defaults.beam_width = std::stoi(args["--beam_width"]);
+            if (args.contains("--exact_memory_mb"))
+                defaults.exact_memory_bytes = std::stoull(args["--exact_memory_mb"]) << 20;
+            defaults.exact = args.contains("--exact");
+            defaults.portfolio = args.contains("--portfolio");
+            defaults.deterministic = args.contains("--deterministic");
+            defaults.limits = search_limits(args);
+            SolverService service(graph_data, num_threads);
+            service.serve(std::cin, responses, defaults);
+            std::cout.rdbuf(responses.rdbuf());
+            return 0;
+        }
+        std::optional<GraphContraction> contraction;
+        if (args.contains("--contract") && !graph_data.fast_travel) {
+            contraction.emplace(graph_data);
+            std::cout << "Contracted graph from " << graph_data.vertex_count << " vertices and "
+                      << graph_data.graph.edge_count() << " edges to " << contraction->reduced().vertex_count
+                      << " vertices and " << contraction->reduced().graph.edge_count() << " edges" << std::endl;
+        }
+        const GraphData& search_graph = contraction ? contraction->reduced() : graph_data;
+        Path best_path;
+        if (args.contains("--exact")) {
+            const size_t max_table_bytes = args.contains("--exact_memory_mb")
+                                               ? std::stoull(args["--exact_memory_mb"]) << 20
+                                               : ExactSolver::default_max_table_bytes;
+            // fast travel moves all cost 1, so only walking maps need the all-pairs stop distances
+            std::optional<DistanceOracle> oracle;
+            if (!search_graph.fast_travel)
+                oracle.emplace(search_graph, num_threads);
+            ExactSolver solver(search_graph, oracle ? &*oracle : nullptr, num_threads, max_table_bytes);
+            solver.set_limits(search_limits(args));
+            best_path = solver.solve();
+            // the exact solver has no intermediate routes, its only improvement is the optimum itself
+            if (args.contains("--stream_improvements") && std::isfinite(best_path.length))
+                print_improvement(best_path);
+        } else if (search_graph.fast_travel) {
+            reject_options(
+                args,
+                {"--max_queue_size", "--error_afford", "--depth_of_search", "--metrics_file", "--metrics_interval_seconds"},
+                "the fast travel solver, which is sized with --beam_width"
+            );
+            FastTravelSolver solver(
+                search_graph,
+                num_threads,
+                args.contains("--beam_width") ? std::stoi(args["--beam_width"]) : FastTravelSolver::default_beam_width
+            );
+            solver.set_limits(search_limits(args));
+            if (args.contains("--log_interval_seconds"))
+                solver.log_progress(std::stof(args["--log_interval_seconds"]));
+            if (args.contains("--stream_improvements"))
+                solver.on_improvement(print_improvement);
+            // --deterministic needs no switch: the beam search does not depend on thread timing
+            solver.optimize();
+            best_path = solver.get_best_path();
+        } else if (args.contains("--portfolio")) {
+            reject_options(args, {"--metrics_file", "--metrics_interval_seconds"}, "--portfolio");
+            PortfolioSolver solver(
+                search_graph,
+                num_threads,
+                std::stoi(args["--max_queue_size"]),
+                std::stod(args["--error_afford"]),
+                std::stoi(args["--depth_of_search"])
+            );
+            solver.set_limits(search_limits(args));
+            solver.set_deterministic(args.contains("--deterministic"));
+            if (args.contains("--stream_improvements"))
+                solver.on_improvement(print_improvement);
+            solver.optimize();
+            best_path = solver.get_best_path();
+        } else {
+            QuestOptimizer optimizer(
+                search_graph,
+                num_threads,
+                std::stoi(args["--max_queue_size"]),
+                std::stod(args["--error_afford"]),
+                std::stoi(args["--depth_of_search"]),
+                std::stof(args["--log_interval_seconds"])
+            );
+            optimizer.set_limits(search_limits(args));
+            optimizer.set_deterministic(args.contains("--deterministic"));
+            if (args.contains("--stream_improvements"))
+                optimizer.on_improvement(print_improvement);
+            std::ofstream metrics_file;
+            if (args.contains("--metrics_file")) {
+                metrics_file.open(args["--metrics_file"]);
+                if (!metrics_file)
+                    throw std::runtime_error("Cannot open metrics file " + args["--metrics_file"]);
+                optimizer.report_metrics(
+                    metrics_file,
+                    args.contains("--metrics_interval_seconds") ? std::stof(args["--metrics_interval_seconds"]) : 1.0f
+                );
+            }
+            optimizer.optimize();
+            best_path = optimizer.get_best_path();
+        }
+        if (contraction)
+            best_path = contraction->expand(best_path);
         print_quests_on_path(
-            optimizer.get_best_path(),
+            best_path,
             graph_data.quest_lines,
+            graph_data.stop_index,
             graph_data.vertex_names,
             args.contains("--enable_vertex_names"),
             args.contains("--enable_quest_line_names")
@@ -0,0 +1,50 @@
+#include "mapped_file.hpp"
+#include "parser.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& file_path) {
+    const int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw InvalidFormat("Unable to open file: " + file_path);
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) == -1) {
+        ::close(fd);
+        throw InvalidFormat("Unable to stat file: " + file_path);
+    }
+    size = static_cast<size_t>(file_stat.st_size);
+    if (size > 0) {
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw InvalidFormat("Unable to map file: " + file_path);
+        }
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr && fallback_buffer.empty())
+        ::munmap(const_cast<char*>(data), size);
+}
+#else
+#include <fstream>
+#include <iterator>
+
+MappedFile::MappedFile(const std::string& file_path) {
+    std::ifstream infile(file_path, std::ios::binary);
+    if (!infile)
+        throw InvalidFormat("Unable to open file: " + file_path);
+    fallback_buffer.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    data = fallback_buffer.data();
+    size = fallback_buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+#endif
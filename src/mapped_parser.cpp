@@ -0,0 +1,5 @@
+#include "mapped_parser.hpp"
+
+GraphData MappedParser::parse_file(const std::string& file_path, const unsigned num_threads) {
+    return Parser(num_threads).parse(file_path);
+}
@@ -0,0 +1,66 @@
+#include "memory_usage.hpp"
+
+#if defined(__linux__)
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+size_t resident_set_bytes() {
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr)
+        return 0;
+    unsigned long total_pages = 0;
+    unsigned long resident_pages = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &total_pages, &resident_pages);
+    std::fclose(statm);
+    return fields == 2 ? resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+size_t peak_resident_set_bytes() {
+    std::FILE* status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr)
+        return 0;
+    char line[256];
+    unsigned long peak_kib = 0;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            std::sscanf(line + 6, "%lu", &peak_kib);
+            break;
+        }
+    }
+    std::fclose(status);
+    return peak_kib * 1024;
+}
+
+void reset_peak_resident_set() {
+    // writing 5 to clear_refs resets VmHWM to the current resident set size
+    if (std::FILE* clear_refs = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", clear_refs);
+        std::fclose(clear_refs);
+    }
+}
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+
+size_t resident_set_bytes() {
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+}
+
+size_t peak_resident_set_bytes() {
+    rusage usage{};
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) : 0;
+}
+
+void reset_peak_resident_set() {}
+#else
+size_t resident_set_bytes() { return 0; }
+
+size_t peak_resident_set_bytes() { return 0; }
+
+void reset_peak_resident_set() {}
+#endif
@@ -1,15 +1,16 @@
 #include <algorithm>
-#include <filesystem>
-#include <fstream>
+#include <charconv>
+#include <exception>
 #include <iostream>
-#include <sstream>
+#include <span>
+#include <string_view>
+#include <thread>
 
+#include "mapped_file.hpp"
 #include "parser.hpp"
 
-namespace fs = std::filesystem;
-
 namespace {
-void sort_and_merge_edges(std::vector<Edge>& edges) {
+size_t sort_and_merge_edges(const std::span<Edge> edges) {
     std::ranges::stable_sort(edges, {}, &Edge::to);
     size_t write_index = 0;
     for (const auto& edge : edges) {
@@ -19,203 +20,477 @@ void sort_and_merge_edges(std::vector<Edge>& edges) {
             edges[write_index++] = edge;
         }
     }
-    edges.resize(write_index);
+    return write_index;
 }
 
-std::vector<std::string> extract_words(const std::string& input) {
-    std::vector<std::string> words;
-    std::istringstream stream(input);
-    std::string word;
-    while (stream >> word) {
-        words.push_back(word);
-    }
-    return words;
+constexpr size_t min_lines_per_chunk = 1 << 14;
+constexpr size_t min_bytes_per_chunk = 1 << 18;
+
+size_t chunk_count_for(const size_t item_count, const size_t min_chunk_size, const unsigned num_threads) {
+    return std::clamp<size_t>(item_count / min_chunk_size, 1, std::max(num_threads, 1u));
 }
-} // namespace
-std::vector<std::string> Parser::lines{};
-LineIter Parser::current_line{};
-GraphData Parser::graph_data{};
 
-void Parser::read_file(const std::string& file_path) {
-    std::cout << "Reading file " << file_path << "\n";
-    const fs::path file_path_(file_path);
-    std::ifstream infile(file_path_);
-    if (!infile) {
-        throw InvalidFormat("Unable to open file: " + file_path);
+// Calls `body(begin, end, chunk)` for `chunk_count` contiguous chunks of [0, item_count), one thread per chunk.
+// If chunks throw, the exception of the lowest chunk is rethrown, which is the one a sequential loop would hit.
+template <typename Body>
+void for_each_chunk(const size_t item_count, const size_t chunk_count, Body&& body) {
+    std::vector<std::exception_ptr> errors(chunk_count);
+    const auto run_chunk = [&](const size_t chunk) {
+        try {
+            body(item_count * chunk / chunk_count, item_count * (chunk + 1) / chunk_count, chunk);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        threads.emplace_back(run_chunk, chunk);
     }
-    std::string raw;
-    while (std::getline(infile, raw)) {
-        if (!raw.empty() && raw.back() == '\r')
-            raw.pop_back();
-        lines.push_back(raw);
+    run_chunk(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
     }
 }
+} // namespace
 
-void Parser::parse_fast_travel() {
-    std::cout << "Parsing fast_travel\n";
-    if (*current_line == "\tTrue") {
-        graph_data.fast_travel = true;
-    } else if (*current_line == "\tFalse") {
-        graph_data.fast_travel = false;
-    } else {
-        throw InvalidFormat("Invalid Format Of <FastTravel> statement");
-    }
+CsrGraph CsrGraph::from_arrays(std::vector<int> offsets, std::vector<int> targets, std::vector<double> weights) {
+    struct Storage {
+        std::vector<int> offsets;
+        std::vector<int> targets;
+        std::vector<double> weights;
+    };
+    auto storage = std::make_shared<Storage>(std::move(offsets), std::move(targets), std::move(weights));
+    return view(storage->offsets, storage->targets, storage->weights, storage);
 }
 
-void Parser::parse_bidirectional() {
-    std::cout << "Parsing bidirectional\n";
-    if (*current_line == "\tTrue") {
-        graph_data.bidirectional = true;
-    } else if (*current_line == "\tFalse") {
-        graph_data.bidirectional = false;
-    } else {
-        throw InvalidFormat("Invalid Format Of <Bidirectional> statement");
+CsrGraph CsrGraph::view(
+    const std::span<const int> offsets,
+    const std::span<const int> targets,
+    const std::span<const double> weights,
+    std::shared_ptr<const void> backing
+) {
+    CsrGraph graph;
+    graph.offsets = offsets;
+    graph.targets = targets;
+    graph.weights = weights;
+    graph.backing = std::move(backing);
+    return graph;
+}
+
+CsrGraph CsrGraph::from_adjacency(const std::vector<std::vector<Edge>>& adj_list) {
+    std::vector<int> offsets(adj_list.size() + 1);
+    for (size_t vertex = 0; vertex < adj_list.size(); ++vertex) {
+        offsets[vertex + 1] = offsets[vertex] + static_cast<int>(adj_list[vertex].size());
+    }
+    std::vector<int> targets;
+    std::vector<double> weights;
+    targets.reserve(offsets.back());
+    weights.reserve(offsets.back());
+    for (const auto& edges : adj_list) {
+        for (const auto& edge : edges) {
+            targets.push_back(edge.to);
+            weights.push_back(edge.weight);
+        }
     }
+    return from_arrays(std::move(offsets), std::move(targets), std::move(weights));
 }
 
-void Parser::parse_weighted() {
-    std::cout << "Parsing weighted\n";
-    if (*current_line == "\tTrue") {
-        graph_data.weighted = true;
-    } else if (*current_line == "\tFalse") {
-        graph_data.weighted = false;
-    } else {
-        throw InvalidFormat("Invalid Format Of <Weighted> statement");
+CsrGraph CsrGraph::from_edge_list(
+    const int vertex_count,
+    const std::vector<EdgeRecord>& edges,
+    const unsigned num_threads
+) {
+    std::vector<int> bucket_offsets(vertex_count + 1, 0);
+    for (const auto& edge : edges) {
+        ++bucket_offsets[edge.from + 1];
+    }
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        bucket_offsets[vertex + 1] += bucket_offsets[vertex];
+    }
+    std::vector<Edge> buckets(edges.size());
+    std::vector<int> fill(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (const auto& edge : edges) {
+        buckets[fill[edge.from]++] = {edge.to, edge.weight};
+    }
+
+    const auto bucket_of = [&](const size_t vertex) {
+        const auto bucket_size = static_cast<size_t>(bucket_offsets[vertex + 1] - bucket_offsets[vertex]);
+        return std::span(buckets).subspan(bucket_offsets[vertex], bucket_size);
+    };
+    const auto vertexes = static_cast<size_t>(vertex_count);
+    const size_t chunk_count = chunk_count_for(edges.size(), min_lines_per_chunk, num_threads);
+    std::vector<int> offsets(vertex_count + 1, 0);
+    for_each_chunk(vertexes, chunk_count, [&](const size_t begin, const size_t end, size_t) {
+        for (size_t vertex = begin; vertex < end; ++vertex) {
+            offsets[vertex + 1] = static_cast<int>(sort_and_merge_edges(bucket_of(vertex)));
+        }
+    });
+    for (size_t vertex = 0; vertex < vertexes; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
     }
+
+    std::vector<int> targets(offsets.back());
+    std::vector<double> weights(offsets.back());
+    for_each_chunk(vertexes, chunk_count, [&](const size_t begin, const size_t end, size_t) {
+        for (size_t vertex = begin; vertex < end; ++vertex) {
+            int write_index = offsets[vertex];
+            for (const auto& edge : bucket_of(vertex).first(offsets[vertex + 1] - offsets[vertex])) {
+                targets[write_index] = edge.to;
+                weights[write_index] = edge.weight;
+                ++write_index;
+            }
+        }
+    });
+    return from_arrays(std::move(offsets), std::move(targets), std::move(weights));
 }
 
-void Parser::parse_vertex_count() {
-    std::cout << "Parsing vertex count\n";
-    if (const auto value = current_line->substr(1); !value.empty() && std::ranges::all_of(value, isdigit)) {
-        const auto vertex_count = std::stoi(value);
-        if (vertex_count < 0) {
-            throw InvalidFormat("<VertexCount> is less then 0");
+QuestStopIndex QuestStopIndex::build(const std::vector<QuestLine>& quest_lines, const int vertex_count) {
+    QuestStopIndex index;
+    index.offsets.assign(vertex_count + 1, 0);
+    for (const auto& quest_line : quest_lines) {
+        for (const int vertex : quest_line.vertexes) {
+            ++index.offsets[vertex + 1];
         }
-        graph_data.vertex_count = vertex_count;
-    } else {
-        throw InvalidFormat("Invalid Format Of <Start> statement");
     }
-    graph_data.vertex_names.resize(graph_data.vertex_count);
-    graph_data.adj_list.assign(graph_data.vertex_count, {});
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        index.offsets[vertex + 1] += index.offsets[vertex];
+    }
+    // filling in quest line order keeps every vertex's stops sorted by quest id and position
+    index.stops.resize(index.offsets.back());
+    std::vector<int> fill(index.offsets.begin(), index.offsets.end() - 1);
+    for (size_t quest_id = 0; quest_id < quest_lines.size(); ++quest_id) {
+        const auto& vertexes = quest_lines[quest_id].vertexes;
+        for (size_t position = 0; position < vertexes.size(); ++position) {
+            index.stops[fill[vertexes[position]]++] = {static_cast<int>(quest_id), static_cast<int>(position)};
+        }
+    }
+    return index;
+}
+
+namespace {
+enum class Section { None, FastTravel, Bidirectional, Weighted, VertexCount, Vertexes, Edges, QuestLines, Start };
+
+Section section_of(const std::string_view line) {
+    if (line.empty() || line.back() != ':')
+        return Section::None;
+    if (line == "FastTravel:")
+        return Section::FastTravel;
+    if (line == "Bidirectional:")
+        return Section::Bidirectional;
+    if (line == "Weighted:")
+        return Section::Weighted;
+    if (line == "VertexCount:")
+        return Section::VertexCount;
+    if (line == "Vertexes:")
+        return Section::Vertexes;
+    if (line == "Edges:")
+        return Section::Edges;
+    if (line == "QuestLines:")
+        return Section::QuestLines;
+    if (line == "Start:")
+        return Section::Start;
+    return Section::None;
 }
 
-void Parser::parse_vertexes() {
-    std::cout << "Parsing vertexes\n";
-    if (graph_data.vertex_count == 0)
-        throw InvalidFormat("<VertexCount> hasn't been defined yet");
+class LineReader {
+public:
+    explicit LineReader(const std::string_view data) : rest(data) {}
 
-    graph_data.vertex_names.resize(graph_data.vertex_count);
-    for (int i = 0; i < graph_data.vertex_count; ++i) {
-        graph_data.vertex_names[i] = "vertex_" + std::to_string(i);
+    bool next(std::string_view& line) {
+        if (rest.empty())
+            return false;
+        const size_t end = rest.find('\n');
+        line = rest.substr(0, end);
+        rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return true;
     }
 
-    for (; current_line != lines.end() && !string_to_parse_func.contains(*current_line); ++current_line) {
-        const auto words = extract_words(*current_line);
-        const int index = std::stoi(words[0]);
+    std::string_view remaining() const { return rest; }
 
-        if (index < 0 || index >= graph_data.vertex_count)
-            throw InvalidFormat("Vertex index is out of bounds");
+private:
+    std::string_view rest;
+};
 
-        if (words.size() > 1) {
-            graph_data.vertex_names[index] = words[1];
+class TokenReader {
+public:
+    explicit TokenReader(const std::string_view line) : rest(line) {}
+
+    bool next(std::string_view& token) {
+        const size_t begin = rest.find_first_not_of(" \t\v\f");
+        if (begin == std::string_view::npos) {
+            rest = {};
+            return false;
         }
+        rest.remove_prefix(begin);
+        const size_t end = std::min(rest.find_first_of(" \t\v\f"), rest.size());
+        token = rest.substr(0, end);
+        rest.remove_prefix(end);
+        return true;
     }
-    --current_line;
+
+private:
+    std::string_view rest;
+};
+
+bool all_digits(const std::string_view token) {
+    return !token.empty() && std::ranges::all_of(token, [](const char c) { return c >= '0' && c <= '9'; });
 }
 
-void Parser::parse_edges() {
-    std::cout << "Parsing edges\n";
-    for (; current_line != lines.end() && !string_to_parse_func.contains(*current_line); ++current_line) {
-        const auto words = extract_words(*current_line);
-        if (words.size() != 2 && words.size() != 3) {
-            throw InvalidFormat("Invalid Format in <Edges> statement");
-        }
-        if (graph_data.vertex_count == 0) {
-            throw InvalidFormat("<VertexCount> hasn't been defined yet");
+template <typename Number>
+bool parse_number(const std::string_view token, Number& value) {
+    const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+    return error == std::errc{} && end == token.data() + token.size();
+}
+
+bool parse_flag(const std::string_view line, const char* statement) {
+    if (line == "\tTrue")
+        return true;
+    if (line == "\tFalse")
+        return false;
+    throw InvalidFormat(std::string("Invalid Format Of <") + statement + "> statement");
+}
+
+int parse_single_index(const std::string_view line, const char* statement) {
+    int value = 0;
+    const auto token = line.substr(std::min<size_t>(1, line.size()));
+    if (!all_digits(token) || !parse_number(token, value))
+        throw InvalidFormat(std::string("Invalid Format Of <") + statement + "> statement");
+    return value;
+}
+
+// Splits `block` into at most `chunk_count` consecutive pieces of roughly equal size, each ending at a line end.
+std::vector<std::string_view> split_at_lines(const std::string_view block, const size_t chunk_count) {
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t chunk = 1; chunk <= chunk_count && begin < block.size(); ++chunk) {
+        size_t end = block.size();
+        if (chunk < chunk_count) {
+            const size_t newline = block.find('\n', std::max(begin, block.size() * chunk / chunk_count));
+            end = newline == std::string_view::npos ? block.size() : newline + 1;
         }
-        if (words.size() == 3 && !graph_data.weighted) {
-            throw InvalidFormat("<Weighted> is False, but <Edges> statement contains 3 tokens");
+        chunks.push_back(block.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+class Reader {
+public:
+    Reader(const std::string_view data, const unsigned num_threads) : lines(data), num_threads(num_threads) {
+        has_line = lines.next(line);
+    }
+
+    GraphData parse() {
+        while (has_line) {
+            switch (section_of(line)) {
+            case Section::None:
+                advance();
+                break;
+            case Section::FastTravel:
+                graph_data.fast_travel = parse_flag(value_line("FastTravel"), "FastTravel");
+                advance();
+                break;
+            case Section::Bidirectional:
+                graph_data.bidirectional = parse_flag(value_line("Bidirectional"), "Bidirectional");
+                advance();
+                break;
+            case Section::Weighted:
+                graph_data.weighted = parse_flag(value_line("Weighted"), "Weighted");
+                advance();
+                break;
+            case Section::VertexCount:
+                parse_vertex_count(value_line("VertexCount"));
+                advance();
+                break;
+            case Section::Start:
+                parse_start(value_line("Start"));
+                advance();
+                break;
+            case Section::Vertexes:
+                parse_vertexes(take_block());
+                break;
+            case Section::Edges:
+                parse_edges(take_block());
+                break;
+            case Section::QuestLines:
+                parse_quest_lines(take_block());
+                break;
+            }
         }
-        if (words.size() == 2 && graph_data.weighted) {
-            throw InvalidFormat("<Weighted> is True, but <Edges> statement contains 2 tokens");
+        const auto out_of_range = [this](const int vertex) { return vertex >= graph_data.vertex_count; };
+        for (const auto& quest_line : graph_data.quest_lines) {
+            if (std::ranges::any_of(quest_line.vertexes, out_of_range))
+                throw InvalidFormat("Vertex index is out of range");
         }
-        const auto first = std::stoi(words[0]);
-        const auto second = std::stoi(words[1]);
-        const auto edge = graph_data.weighted ? std::stod(words[2]) : 1.0;
-        if (first < 0 || first > graph_data.vertex_count - 1 || second < 0 || second > graph_data.vertex_count - 1) {
-            throw InvalidFormat("Vertex index is out of range");
+        graph_data.graph = CsrGraph::from_edge_list(graph_data.vertex_count, edges, num_threads);
+        graph_data.stop_index = QuestStopIndex::build(graph_data.quest_lines, graph_data.vertex_count);
+        return std::move(graph_data);
+    }
+
+private:
+    LineReader lines;
+    const unsigned num_threads;
+    std::string_view line;
+    bool has_line = false;
+    GraphData graph_data{};
+    std::vector<EdgeRecord> edges;
+
+    void advance() { has_line = lines.next(line); }
+
+    std::string_view value_line(const char* statement) {
+        advance();
+        if (!has_line)
+            throw InvalidFormat(std::string("Missing value of <") + statement + "> statement");
+        return line;
+    }
+
+    // Text of the lines after the current section header, up to the next header, which becomes the current line.
+    std::string_view take_block() {
+        const std::string_view rest = lines.remaining();
+        for (advance(); has_line && section_of(line) == Section::None; advance()) {
         }
-        if (edge < 0) {
-            throw InvalidFormat("Edge length is less then 0");
+        return has_line ? rest.substr(0, line.data() - rest.data()) : rest;
+    }
+
+    // Calls `parse_line(line, chunk)` for every line of `block`, with the block split into chunks across threads.
+    // Returns the number of chunks; the first error in file order is rethrown.
+    template <typename ParseLine>
+    size_t for_each_line(const std::string_view block, ParseLine&& parse_line) const {
+        const auto chunks = split_at_lines(block, chunk_count_for(block.size(), min_bytes_per_chunk, num_threads));
+        if (chunks.empty())
+            return 0;
+        for_each_chunk(chunks.size(), chunks.size(), [&](const size_t, const size_t, const size_t chunk) {
+            LineReader chunk_lines(chunks[chunk]);
+            for (std::string_view chunk_line; chunk_lines.next(chunk_line);) {
+                parse_line(chunk_line, chunk);
+            }
+        });
+        return chunks.size();
+    }
+
+    void parse_vertex_count(const std::string_view value) {
+        const int vertex_count = parse_single_index(value, "VertexCount");
+        graph_data.vertex_count = vertex_count;
+        graph_data.vertex_names.resize(vertex_count);
+    }
+
+    void parse_start(const std::string_view value) {
+        const int start_index = parse_single_index(value, "Start");
+        if (graph_data.vertex_count == 0)
+            throw InvalidFormat("<VertexCount> hasn't been defined yet");
+        if (start_index < 0 || start_index >= graph_data.vertex_count)
+            throw InvalidFormat("<StartIndex> is out of range");
+        graph_data.start_index = start_index;
+    }
+
+    void parse_vertexes(const std::string_view block) {
+        if (graph_data.vertex_count == 0)
+            throw InvalidFormat("<VertexCount> hasn't been defined yet");
+        for (int i = 0; i < graph_data.vertex_count; ++i) {
+            graph_data.vertex_names[i] = "vertex_" + std::to_string(i);
         }
-        graph_data.adj_list[first].push_back({second, edge});
-        if (graph_data.bidirectional) {
-            graph_data.adj_list[second].push_back({first, edge});
+        LineReader block_lines(block);
+        for (std::string_view vertex_line; block_lines.next(vertex_line);) {
+            TokenReader tokens(vertex_line);
+            std::string_view token;
+            int index = 0;
+            if (!tokens.next(token) || !parse_number(token, index) || index < 0 || index >= graph_data.vertex_count)
+                throw InvalidFormat("Vertex index is out of bounds");
+            if (tokens.next(token))
+                graph_data.vertex_names[index] = token;
         }
     }
-    for (auto& edges : graph_data.adj_list) {
-        sort_and_merge_edges(edges);
-    }
-    --current_line;
-}
 
-void Parser::parse_quest_lines() {
-    std::cout << "Parsing quest lines\n";
-    for (int i = 0; current_line != lines.end() && !string_to_parse_func.contains(*current_line); ++i, ++current_line) {
-        std::vector<std::string> words = extract_words(*current_line);
-        auto vertexes_end_it = words.end();
-        std::string name = "quest_" + std::to_string(i);
-        if (!std::ranges::all_of(words.back(), isdigit)) {
-            name = words.back();
-            --vertexes_end_it;
-        }
-        QuestLine ql{.id = i, .name = std::move(name)};
-        for (auto it = words.begin(); it != vertexes_end_it; ++it) {
-            if (!std::ranges::all_of(*it, isdigit))
-                throw InvalidFormat("Invalid Format Of <QuestLine> statement");
-            ql.vertexes.push_back(std::stoi(*it));
+    void parse_edges(const std::string_view block) {
+        std::vector<std::vector<EdgeRecord>> chunk_edges(num_threads);
+        const size_t chunk_count = for_each_line(block, [&](const std::string_view edge_line, const size_t chunk) {
+            parse_edge_line(edge_line, chunk_edges[chunk]);
+        });
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            edges.insert(edges.end(), chunk_edges[chunk].begin(), chunk_edges[chunk].end());
         }
-        graph_data.quest_lines.push_back(std::move(ql));
     }
-    --current_line;
-}
 
-void Parser::parse_start() {
-    std::cout << "Parsing start\n";
-    if (const auto value = current_line->substr(1); !value.empty() && std::ranges::all_of(value, isdigit)) {
-        const auto start_index = std::stoi(value);
-        if (graph_data.vertex_count == 0) {
+    void parse_edge_line(const std::string_view edge_line, std::vector<EdgeRecord>& records) const {
+        TokenReader tokens(edge_line);
+        std::string_view words[4];
+        size_t word_count = 0;
+        while (word_count < 4 && tokens.next(words[word_count])) {
+            ++word_count;
+        }
+        if (word_count != 2 && word_count != 3)
+            throw InvalidFormat("Invalid Format in <Edges> statement");
+        if (graph_data.vertex_count == 0)
             throw InvalidFormat("<VertexCount> hasn't been defined yet");
+        if (word_count == 3 && !graph_data.weighted)
+            throw InvalidFormat("<Weighted> is False, but <Edges> statement contains 3 tokens");
+        if (word_count == 2 && graph_data.weighted)
+            throw InvalidFormat("<Weighted> is True, but <Edges> statement contains 2 tokens");
+        int first = 0;
+        int second = 0;
+        double weight = 1.0;
+        if (!parse_number(words[0], first) || !parse_number(words[1], second) ||
+            (word_count == 3 && !parse_number(words[2], weight)))
+            throw InvalidFormat("Invalid Format in <Edges> statement");
+        if (first < 0 || first > graph_data.vertex_count - 1 || second < 0 || second > graph_data.vertex_count - 1)
+            throw InvalidFormat("Vertex index is out of range");
+        if (weight < 0)
+            throw InvalidFormat("Edge length is less then 0");
+        records.push_back({first, second, weight});
+        if (graph_data.bidirectional)
+            records.push_back({second, first, weight});
+    }
+
+    // Quest ids continue across QuestLines sections, so ids and default names are assigned when chunks are merged.
+    void parse_quest_lines(const std::string_view block) {
+        std::vector<std::vector<QuestLine>> chunk_quest_lines(num_threads);
+        const size_t chunk_count = for_each_line(block, [&](const std::string_view quest_line, const size_t chunk) {
+            chunk_quest_lines[chunk].push_back(parse_quest_line(quest_line));
+        });
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            for (auto& quest_line : chunk_quest_lines[chunk]) {
+                quest_line.id = static_cast<int>(graph_data.quest_lines.size());
+                if (quest_line.name.empty())
+                    quest_line.name = "quest_" + std::to_string(quest_line.id);
+                graph_data.quest_lines.push_back(std::move(quest_line));
+            }
         }
-        if (start_index < 0 || start_index > graph_data.vertex_count) {
-            throw InvalidFormat("<StartIndex> is out of range");
+    }
+
+    static QuestLine parse_quest_line(const std::string_view quest_line_text) {
+        QuestLine quest_line{};
+        TokenReader tokens(quest_line_text);
+        std::string_view token;
+        std::string_view pending_name;
+        while (tokens.next(token)) {
+            if (!pending_name.empty())
+                throw InvalidFormat("Invalid Format Of <QuestLine> statement");
+            int vertex = 0;
+            if (all_digits(token) && parse_number(token, vertex))
+                quest_line.vertexes.push_back(vertex);
+            else
+                pending_name = token;
         }
-        graph_data.start_index = start_index;
-    } else {
-        throw InvalidFormat("Invalid Format Of <Start> statement");
+        if (quest_line.vertexes.empty() && pending_name.empty())
+            throw InvalidFormat("Invalid Format Of <QuestLine> statement");
+        quest_line.name = pending_name;
+        return quest_line;
     }
-}
+};
+} // namespace
+
+Parser::Parser(const unsigned num_threads) : num_threads(std::max(num_threads, 1u)) {}
 
-// clang-format off
-const std::unordered_map<std::string, void (*)()> Parser::string_to_parse_func = {
-    {"FastTravel:", parse_fast_travel},
-    {"Bidirectional:", parse_bidirectional},
-    {"Weighted:", parse_weighted},
-    {"VertexCount:", parse_vertex_count},
-    {"Vertexes:", parse_vertexes},
-    {"Edges:", parse_edges},
-    {"QuestLines:", parse_quest_lines},
-    {"Start:", parse_start}};
-// clang-format on
-
-GraphData Parser::parse_file(const std::string& file_path) {
-    read_file(file_path);
-    for (current_line = lines.begin(); current_line != lines.end(); ++current_line) {
-        if (string_to_parse_func.contains(*current_line)) {
-            const auto parse_func = *string_to_parse_func.at(*current_line);
-            ++current_line;
-            parse_func();
-        }
-    }
-    return graph_data;
+GraphData Parser::parse(const std::string& file_path) const {
+    std::cout << "Reading file " << file_path << "\n";
+    const MappedFile file(file_path);
+    return Reader(file.view(), num_threads).parse();
 }
+
+GraphData Parser::parse_file(const std::string& file_path) { return Parser().parse(file_path); }
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "path_store.hpp"
+
+PathStore::~PathStore() {
+    for (auto& chunk : chunks) {
+        delete[] chunk.load(std::memory_order::relaxed);
+    }
+}
+
+PathStore::Node* PathStore::chunk_for(const size_t node_index) {
+    auto& slot = chunks[node_index >> chunk_bits];
+    Node* chunk = slot.load(std::memory_order::acquire);
+    if (chunk != nullptr)
+        return chunk;
+    auto* fresh = new Node[chunk_size];
+    if (slot.compare_exchange_strong(chunk, fresh, std::memory_order::acq_rel, std::memory_order::acquire))
+        return fresh;
+    delete[] fresh;
+    return chunk;
+}
+
+PathHandle PathStore::append(const PathHandle parent, const int vertex) {
+    const auto handle = try_append(parent, vertex);
+    if (!handle)
+        throw std::length_error("PathStore is out of path nodes");
+    return *handle;
+}
+
+std::optional<PathHandle> PathStore::try_append(const PathHandle parent, const int vertex) {
+    // a full arena leaves the counter alone, so node_count() never reports more nodes than were stored
+    size_t node_index = next_node.load(std::memory_order::relaxed);
+    do {
+        if (node_index >= empty_path)
+            return std::nullopt;
+    } while (!next_node.compare_exchange_weak(node_index, node_index + 1, std::memory_order::relaxed));
+    chunk_for(node_index)[node_index & (chunk_size - 1)] = {parent, vertex};
+    return static_cast<PathHandle>(node_index);
+}
+
+std::vector<int> PathStore::materialize(PathHandle handle) const {
+    std::vector<int> vertexes;
+    for (; handle != empty_path; handle = node(handle).parent) {
+        vertexes.push_back(node(handle).vertex);
+    }
+    std::ranges::reverse(vertexes);
+    return vertexes;
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "portfolio_solver.hpp"
+
+namespace {
+// Member settings handed out in turn, from greedy to more exhaustive.
+struct MemberProfile {
+    double error_afford_step;
+    // Share of the per-thread queue size; the ladder averages to one so memory stays as without a portfolio.
+    double queue_scale;
+};
+constexpr MemberProfile member_ladder[] = {{1.0, 0.5}, {1.05, 1.0}, {1.1, 1.5}};
+} // namespace
+
+PortfolioSolver::PortfolioSolver(
+    const GraphData& graph_data,
+    const unsigned num_threads,
+    const unsigned max_queue_size,
+    const double error_afford,
+    const unsigned depth_of_search,
+    std::shared_ptr<const DistanceOracle> oracle
+)
+    : graph_data(graph_data),
+      num_threads(std::max(num_threads, 1u)),
+      max_queue_size(max_queue_size),
+      error_afford(error_afford),
+      depth_of_search(depth_of_search),
+      oracle(std::move(oracle)) {}
+
+void PortfolioSolver::optimize() {
+    const auto begin = std::chrono::steady_clock::now();
+    if (graph_data.fast_travel)
+        throw std::invalid_argument("PortfolioSolver searches walking maps, use FastTravelSolver for fast travel");
+    const auto reachability = std::make_shared<const StopReachability>(graph_data);
+    reachability->require_feasible();
+    if (!oracle) {
+        std::cout << "Building distance oracle" << std::endl;
+        oracle = std::make_shared<const DistanceOracle>(graph_data, num_threads);
+    }
+
+    const auto seeds = QuestOptimizer::seed_vertices(graph_data, reachability.get());
+    const size_t member_count = std::clamp<size_t>(num_threads * members_per_thread, 1, std::max<size_t>(seeds.size(), 1));
+    std::vector<std::vector<int>> groups(member_count);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        groups[i % member_count].push_back(seeds[i]);
+    }
+    std::cout << "Portfolio of " << member_count << " searches over " << seeds.size() << " starts" << std::endl;
+
+    const auto member_queue_size = std::max(max_queue_size / num_threads, 1u);
+    const size_t worker_count = std::min<size_t>(num_threads, member_count);
+    std::vector<Path> member_paths(member_count, best_path);
+    std::atomic<size_t> next_member{0};
+    std::atomic<size_t> proven_members{0};
+    std::atomic<bool> found_route{false};
+    const auto worker = [&] {
+        for (size_t member = next_member.fetch_add(1, std::memory_order::relaxed); member < member_count;
+             member = next_member.fetch_add(1, std::memory_order::relaxed)) {
+            SearchLimits member_limits = limits;
+            if (limits.time_budget.count() > 0) {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - begin
+                );
+                // past the budget, members still start on a token budget until one returns a route
+                if (elapsed >= limits.time_budget && found_route.load(std::memory_order::relaxed))
+                    return;
+                // members not started yet run in waves of `worker_count`, this one gets its wave's share
+                const auto waves = static_cast<long>((member_count - member + worker_count - 1) / worker_count);
+                member_limits.time_budget = std::max(
+                    std::max(limits.time_budget - elapsed, std::chrono::milliseconds{0}) / waves,
+                    std::chrono::milliseconds{1}
+                );
+            }
+            const auto& profile = member_ladder[member % std::size(member_ladder)];
+            QuestOptimizer optimizer(
+                graph_data,
+                1,
+                std::max(static_cast<unsigned>(member_queue_size * profile.queue_scale), 1u),
+                error_afford * profile.error_afford_step,
+                depth_of_search,
+                0.0,
+                oracle
+            );
+            std::atomic<double> member_incumbent{std::numeric_limits<double>::infinity()};
+            optimizer.join_portfolio(deterministic ? member_incumbent : shared_incumbent, groups[member], reachability);
+            optimizer.set_limits(member_limits);
+            optimizer.set_deterministic(deterministic);
+            if (improvement_callback) {
+                optimizer.on_improvement([&](const Path& path) {
+                    const std::scoped_lock lock(improvement_mutex);
+                    if (path.length < published_length) {
+                        published_length = path.length;
+                        improvement_callback(path);
+                    }
+                });
+            }
+            optimizer.optimize();
+            if (optimizer.is_proven_optimal())
+                proven_members.fetch_add(1, std::memory_order::relaxed);
+            member_paths[member] = optimizer.get_best_path();
+            if (std::isfinite(member_paths[member].length))
+                found_route.store(true, std::memory_order::relaxed);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < worker_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // ties go to the lowest member, not to whichever finished first
+    for (auto& member_path : member_paths) {
+        if (member_path.length < best_path.length)
+            best_path = std::move(member_path);
+    }
+
+    proven_optimal = proven_members.load() == member_count && std::isfinite(best_path.length);
+    if (proven_optimal)
+        std::cout << "Search space exhausted, path is optimal" << std::endl;
+    else if (!std::isfinite(best_path.length))
+        std::cerr << "[ERROR] No valid path found by the portfolio." << std::endl;
+}
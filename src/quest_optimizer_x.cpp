@@ -1,33 +1,64 @@
 #include <algorithm>
+#include <barrier>
 #include <cmath>
 #include <iostream>
+#include <iterator>
 #include <numeric>
-#include <queue>
+#include <stdexcept>
 #include <utility>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "local_search.hpp"
+#include "memory_usage.hpp"
 #include "quest_optimizer_x.hpp"
 
 namespace {
+constexpr auto limit_poll_interval = std::chrono::milliseconds(5);
+
 void atomic_fetch_min(std::atomic<unsigned>& value, const unsigned candidate) {
     auto current = value.load(std::memory_order_relaxed);
     while (candidate < current &&
            !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed, std::memory_order_relaxed)) {}
 }
+void atomic_fetch_min(std::atomic<double>& value, const double candidate) {
+    auto current = value.load(std::memory_order_relaxed);
+    while (candidate < current &&
+           !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed, std::memory_order_relaxed)) {}
+}
+// Largest distances[stops[i]] + suffix_lengths[i], at least zero.
+double max_chain_bound(const double* distances, const int* stops, const double* suffix_lengths, const size_t count) {
+    double bound = 0.0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256d bounds = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        const __m128i indexes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stops + i));
+        const __m256d to_next = _mm256_i32gather_pd(distances, indexes, sizeof(double));
+        bounds = _mm256_max_pd(bounds, _mm256_add_pd(to_next, _mm256_loadu_pd(suffix_lengths + i)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, bounds);
+    bound = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < count; ++i) {
+        bound = std::max(bound, distances[stops[i]] + suffix_lengths[i]);
+    }
+    return bound;
+}
+
 void logger_thread_func(
     const std::atomic<unsigned>& found_best_paths,
     const std::atomic<unsigned>& minimum_quest_count,
     const std::atomic<bool>& stop_event,
-    const std::pmr::set<PathState>& queue,
-    std::mutex& queue_mutex,
+    const Frontier<PathState>& frontier,
     const float interval_seconds
 ) {
     while (!stop_event.load(std::memory_order::acquire)) {
         std::this_thread::sleep_for(std::chrono::duration<double>(interval_seconds));
-        size_t queue_size = 0;
-        {
-            const std::scoped_lock lock(queue_mutex);
-            queue_size = queue.size();
-        }
+        const size_t queue_size = frontier.size();
         std::cout << "[Logger Thread] "
                   << "found_best_paths: " << found_best_paths.load(std::memory_order::acquire)
                   << " minimum_quest_count: " << minimum_quest_count.load(std::memory_order::acquire)
@@ -45,174 +76,565 @@ int remain_quests(
     });
 }
 
-std::unordered_map<int, Path> QuestOptimizer::dijkstra_from(const int start) const {
-    std::unordered_map<int, Path> best_paths;
-    std::priority_queue<
-        std::pair<double, std::vector<int>>,
-        std::vector<std::pair<double, std::vector<int>>>,
-        std::greater<>>
-        pq;
-    pq.emplace(0.0, std::vector{start});
-
-    while (!pq.empty()) {
-        const auto [length, path] = pq.top();
-        pq.pop();
-        const int current = path.back();
-
-        if (best_paths.contains(current) && best_paths[current].length <= length)
+std::vector<int> remaining_stop_route(const std::vector<QuestLine>& quest_lines, const std::vector<int>& route) {
+    // every quest line has to stay a subsequence of the suffix, so match each one greedily from the route's end
+    size_t suffix_begin = route.size();
+    for (const auto& quest_line : quest_lines) {
+        auto stop = quest_line.vertexes.rbegin();
+        size_t i = route.size();
+        while (i > 0 && stop != quest_line.vertexes.rend()) {
+            if (route[--i] == *stop)
+                ++stop;
+        }
+        if (stop != quest_line.vertexes.rend())
+            return {};
+        if (!quest_line.vertexes.empty())
+            suffix_begin = std::min(suffix_begin, i);
+    }
+
+    std::vector<size_t> positions(quest_lines.size(), 0);
+    std::vector<int> stop_route;
+    for (size_t i = suffix_begin; i < route.size(); ++i) {
+        bool advanced = false;
+        for (size_t quest_id = 0; quest_id < quest_lines.size(); ++quest_id) {
+            const auto& vertexes = quest_lines[quest_id].vertexes;
+            if (positions[quest_id] < vertexes.size() && vertexes[positions[quest_id]] == route[i]) {
+                ++positions[quest_id];
+                advanced = true;
+            }
+        }
+        if (advanced)
+            stop_route.push_back(route[i]);
+    }
+    return stop_route;
+}
+
+// Only the quest lines with a stop at the state's vertex are looked at, and each of them advances at most once.
+void QuestOptimizer::advance_quests(PathState& state) const {
+    int advanced_quest = -1;
+    for (const auto& [quest_id, position] : graph_data.stop_index.stops_at(state.current_index)) {
+        if (quest_id == advanced_quest ||
+            progress_layout.position(state.quest_progress, quest_id) != static_cast<size_t>(position))
             continue;
+        progress_layout.advance(state.quest_progress, quest_id);
+        --state.remaining_quest_count;
+        advanced_quest = quest_id;
+    }
+}
+
+void QuestOptimizer::record_complete_path(const PathState& state) {
+    atomic_fetch_min(*incumbent_length, state.length);
+    Path coverage{path_store.materialize(state.path), state.length};
+    {
+        const std::scoped_lock lock(best_path_mutex);
+        if (auto& current_best_path = best_path_for_start[coverage.vertexes.front()];
+            current_best_path.vertexes.empty() || current_best_path.length > state.length)
+            current_best_path = coverage;
+        found_best_paths.fetch_add(1, std::memory_order::release);
+    }
+    publish_if_improved(coverage);
+}
 
-        best_paths[current] = Path(path, length);
+Path QuestOptimizer::complete_route(const Path& coverage) const {
+    Path route = coverage;
+    if (graph_data.start_index != -1 && route.vertexes.front() != graph_data.start_index)
+        route.vertexes.insert(route.vertexes.begin(), graph_data.start_index);
+    route.vertexes = oracle->expand(route.vertexes);
+    return route;
+}
 
-        for (const auto& edge : graph_data.adj_list[current]) {
-            auto next_path = path;
-            next_path.emplace_back(edge.to);
-            pq.emplace(length + edge.weight, std::move(next_path));
+void QuestOptimizer::publish_if_improved(const Path& coverage) {
+    if (!improvement_callback)
+        return;
+    const std::scoped_lock lock(publish_mutex);
+    if (coverage.length >= published_length)
+        return;
+    published_length = coverage.length;
+    improvement_callback(complete_route(coverage));
+}
+
+void QuestOptimizer::refine_best_paths(const std::chrono::steady_clock::time_point deadline) {
+    std::vector<Path> candidates;
+    for (const auto& path : best_path_for_start | std::views::values) {
+        if (!path.vertexes.empty() && std::isfinite(path.length))
+            candidates.push_back(path);
+    }
+    std::ranges::sort(candidates, {}, &Path::length);
+    candidates.resize(std::min(candidates.size(), refine_candidate_count));
+    if (candidates.empty())
+        return;
+    std::cout << "Refining " << candidates.size() << " paths with local search" << std::endl;
+
+    LocalSearch local_search(graph_data, oracle.get());
+    local_search.set_budget(
+        limits.time_budget.count() > 0 ? deadline : std::chrono::steady_clock::time_point::max(),
+        limits.max_rss_bytes
+    );
+    // results are applied in candidate order once all workers are done, so ties do not depend on thread timing
+    std::vector<Path> refined(candidates.size());
+    std::atomic<size_t> next_candidate{0};
+    const auto worker = [&] {
+        for (size_t i = next_candidate.fetch_add(1, std::memory_order::relaxed); i < candidates.size();
+             i = next_candidate.fetch_add(1, std::memory_order::relaxed)) {
+            refined[i] = local_search.refine(candidates[i].vertexes);
         }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min<size_t>(num_threads, candidates.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (refined[i].length >= candidates[i].length)
+            continue;
+        if (auto& current_best_path = best_path_for_start[refined[i].vertexes.front()];
+            current_best_path.vertexes.empty() || current_best_path.length > refined[i].length)
+            current_best_path = refined[i];
+        publish_if_improved(refined[i]);
     }
-    return best_paths;
 }
 
-bool QuestOptimizer::update_state(PathState& current_state) {
-    bool local_found = false;
-    current_state.path.vertexes.emplace_back(current_state.current_index);
-    if (minimum_quest_count.load(std::memory_order::acquire) == 0) {
-        minimum_quest_count.store(total_quest_count, std::memory_order::release);
+void QuestOptimizer::watch_limits(const std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock lock(watchdog_mutex);
+    while (!stop_event.load(std::memory_order::acquire)) {
+        const auto now = std::chrono::steady_clock::now();
+        const char* reason = nullptr;
+        if (limits.time_budget.count() > 0 && now >= deadline)
+            reason = "Time budget exhausted";
+        else if (limits.max_rss_bytes > 0 && resident_set_bytes() > limits.max_rss_bytes)
+            reason = "Memory budget exhausted";
+        if (reason != nullptr) {
+            std::cout << reason << ", keeping the best path found so far" << std::endl;
+            search_truncated.store(true, std::memory_order::release);
+            stop_event.store(true, std::memory_order::release);
+            return;
+        }
+        auto wait = limit_poll_interval;
+        if (limits.time_budget.count() > 0)
+            wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(deadline - now));
+        watchdog_wakeup.wait_for(lock, wait, [&] { return stop_event.load(std::memory_order::acquire); });
     }
-    if (current_state.remaining_quest_count <=
-        std::max(minimum_quest_count.load(std::memory_order::acquire), 1u) * error_afford) {
-        cv_queue.notify_all();
+}
+
+void QuestOptimizer::report_metrics_periodically() {
+    const auto interval = std::chrono::duration<double>(metrics_interval_seconds);
+    std::unique_lock lock(watchdog_mutex);
+    while (!watchdog_wakeup.wait_for(lock, interval, [&] { return stop_event.load(std::memory_order::acquire); })) {
+        lock.unlock();
+        search_metrics.write_snapshot(
+            *metrics_out,
+            frontier.size(),
+            incumbent_length->load(std::memory_order::relaxed),
+            false
+        );
+        lock.lock();
+    }
+}
+
+void QuestOptimizer::push_state(PathState&& state, WorkerMetrics* metrics) {
+    if (state.estimate >= incumbent_length->load(std::memory_order::relaxed)) {
+        if (metrics != nullptr)
+            metrics->add(WorkerMetrics::bound_prunes);
+        return;
+    }
+    if (dominance.try_improve(state.current_index, state.quest_progress, state.length))
+        frontier.push(std::move(state), metrics);
+    else if (metrics != nullptr)
+        metrics->add(WorkerMetrics::dominated);
+}
+
+void QuestOptimizer::build_chain_bounds() {
+    chain_offsets.clear();
+    chain_suffix_lengths.clear();
+    for (const auto& quest_line : graph_data.quest_lines) {
+        chain_offsets.push_back(chain_suffix_lengths.size());
+        const auto& vertexes = quest_line.vertexes;
+        std::vector<double> suffix(vertexes.size(), 0.0);
+        for (size_t i = vertexes.size(); i-- > 1;) {
+            suffix[i - 1] = suffix[i] + oracle->distance(vertexes[i - 1], vertexes[i]);
+        }
+        chain_suffix_lengths.insert(chain_suffix_lengths.end(), suffix.begin(), suffix.end());
+    }
+}
+
+void QuestOptimizer::record_previous_route_suffix() {
+    auto stop_route = remaining_stop_route(graph_data.quest_lines, previous_route);
+    if (stop_route.empty())
+        return;
+
+    double length = graph_data.start_index == -1 ? 0.0 : oracle->distance(graph_data.start_index, stop_route.front());
+    for (size_t i = 1; i < stop_route.size(); ++i) {
+        length += oracle->distance(stop_route[i - 1], stop_route[i]);
+    }
+    if (std::isfinite(length))
+        record_coverage(Path{std::move(stop_route), length});
+}
+
+// Makes a route found outside the search workers the incumbent of its first stop.
+void QuestOptimizer::record_coverage(Path coverage) {
+    atomic_fetch_min(*incumbent_length, coverage.length);
+    if (auto& current_best_path = best_path_for_start[coverage.vertexes.front()];
+        current_best_path.vertexes.empty() || current_best_path.length > coverage.length)
+        current_best_path = coverage;
+    publish_if_improved(coverage);
+}
+
+// Takes the best queued state and completes it by always moving to the nearest next stop of an unfinished quest line,
+// so a search stopped by its limits before finishing any route still returns one. False if nothing was queued or a
+// stop turned out to be unreachable.
+bool QuestOptimizer::complete_best_state_greedily() {
+    auto popped_state = frontier.try_pop();
+    if (!popped_state)
+        return false;
+    frontier.task_done();
+    PathState state = std::move(*popped_state);
+    auto stops = path_store.materialize(state.path);
+    while (true) {
+        stops.push_back(state.current_index);
+        advance_quests(state);
+        if (state.remaining_quest_count == 0)
+            break;
+        // same component rule as expand_walking: later components wait until the earliest open one is finished
+        int open_rank = std::numeric_limits<int>::max();
         for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
-            const auto& quest_line = graph_data.quest_lines[quest_id];
-            auto& position = current_state.quest_positions[quest_id];
-            if (position < quest_line.vertexes.size() && quest_line.vertexes[position] == current_state.current_index) {
-                ++position;
-                --current_state.remaining_quest_count;
-            }
+            const auto& vertexes = graph_data.quest_lines[quest_id].vertexes;
+            if (const auto position = progress_layout.position(state.quest_progress, quest_id);
+                position < vertexes.size())
+                open_rank = std::min(open_rank, reachability->rank(vertexes[position]));
         }
-        if (current_state.remaining_quest_count == 0) {
-            {
-                const std::scoped_lock lock(queue_mutex);
-                if (auto& current_best_path = best_path_for_start[current_state.path.vertexes[0]];
-                    current_best_path.vertexes.empty() || current_best_path.length > current_state.path.length)
-                    current_best_path = current_state.path;
-                found_best_paths.fetch_add(1, std::memory_order::release);
-            }
-            minimum_quest_count.store(total_quest_count, std::memory_order::release);
-            local_found = true;
-        } else {
-            for (const auto& edge : graph_data.adj_list[current_state.current_index]) {
-                auto new_state = current_state;
-                new_state.current_index = edge.to;
-                new_state.path.length += edge.weight;
-                const std::scoped_lock lock(queue_mutex);
-                if (queue.size() == max_queue_size) {
-                    const auto worst_it = std::prev(queue.end());
-                    const int rq_new = new_state.remaining_quest_count;
-                    const int rq_worst = worst_it->remaining_quest_count;
-                    if (rq_new < rq_worst || (rq_new == rq_worst && new_state.path.length < worst_it->path.length)) {
-                        queue.erase(worst_it);
-                        queue.insert(std::move(new_state));
-                        if (sleeping_threads > 0)
-                            cv_queue.notify_one();
-                    }
-                } else {
-                    queue.insert(std::move(new_state));
-                    if (sleeping_threads > 0 || queue.empty())
-                        cv_queue.notify_one();
-                }
+        int next_stop = -1;
+        double next_distance = std::numeric_limits<double>::infinity();
+        for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
+            const auto& vertexes = graph_data.quest_lines[quest_id].vertexes;
+            const auto position = progress_layout.position(state.quest_progress, quest_id);
+            if (position >= vertexes.size() || reachability->rank(vertexes[position]) > open_rank)
+                continue;
+            const double distance = oracle->distance(state.current_index, vertexes[position]);
+            if (distance < next_distance) {
+                next_stop = vertexes[position];
+                next_distance = distance;
             }
         }
+        if (next_stop == -1)
+            return false;
+        state.current_index = next_stop;
+        state.length += next_distance;
+    }
+    record_coverage(Path{std::move(stops), state.length});
+    return true;
+}
+
+double QuestOptimizer::lower_bound(const int vertex, const QuestProgress& progress) const {
+    double bound = 0.0;
+    for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
+        const auto& quest_line = graph_data.quest_lines[quest_id];
+        const auto position = progress_layout.position(progress, quest_id);
+        if (position >= quest_line.vertexes.size())
+            continue;
+        const int next_stop = quest_line.vertexes[position];
+        const double to_next = oracle->distance(vertex, next_stop);
+        bound = std::max(bound, to_next + chain_suffix_lengths[chain_offsets[quest_id] + position]);
+    }
+    return bound;
+}
+
+PathState QuestOptimizer::make_state(const int vertex, const double length, const QuestProgress& progress) const {
+    return PathState(
+        vertex,
+        PathStore::empty_path,
+        length,
+        length + lower_bound(vertex, progress),
+        progress,
+        total_quest_count
+    );
+}
+
+void QuestOptimizer::emit_child(
+    PathState&& child,
+    WorkerMetrics& metrics,
+    std::vector<PathState>* deferred_children
+) {
+    if (deferred_children != nullptr)
+        deferred_children->push_back(std::move(child));
+    else
+        push_state(std::move(child), &metrics);
+}
+
+// Records the visit, advances the quest lines and generates the children. Children are queued right away, or kept in
+// `deferred_children` when a deterministic round merges them later; completing a route is left to the caller.
+QuestOptimizer::Expansion QuestOptimizer::expand_state(
+    PathState& state,
+    const unsigned minimum_quests,
+    WorkerMetrics& metrics,
+    OpenQuests& open_quests,
+    std::vector<PathState>* deferred_children
+) {
+    metrics.add(WorkerMetrics::expansions);
+    if (state.remaining_quest_count > std::max(minimum_quests, 1u) * error_afford) {
+        search_truncated.store(true, std::memory_order::relaxed);
+        metrics.add(WorkerMetrics::error_afford_rejections);
+        return Expansion::gated;
+    }
+    const auto path = path_store.try_append(state.path, state.current_index);
+    if (!path) {
+        // out of path node handles: stop like an exhausted memory budget and keep the best route found so far
+        search_truncated.store(true, std::memory_order::release);
+        if (!stop_event.exchange(true, std::memory_order::acq_rel))
+            std::cout << "Path store is full, keeping the best path found so far" << std::endl;
+        return Expansion::gated;
     }
-    return local_found;
+    state.path = *path;
+    advance_quests(state);
+    if (state.remaining_quest_count == 0)
+        return Expansion::complete;
+    expand_walking(state, metrics, open_quests, deferred_children);
+    return Expansion::expanded;
 }
 
-bool QuestOptimizer::update_state_fast_travel(PathState& current_state) {
-    bool local_found = false;
-    current_state.path.vertexes.emplace_back(current_state.current_index);
+void QuestOptimizer::expand_walking(
+    const PathState& state,
+    WorkerMetrics& metrics,
+    OpenQuests& open_quests,
+    std::vector<PathState>* deferred_children
+) {
+    open_quests.next_vertexes.clear();
+    open_quests.next_stops.clear();
+    open_quests.suffix_lengths.clear();
+    // stops of a later component are out of reach until the earliest open one is finished
+    int open_rank = std::numeric_limits<int>::max();
+    for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
+        const auto& vertexes = graph_data.quest_lines[quest_id].vertexes;
+        const auto position = progress_layout.position(state.quest_progress, quest_id);
+        if (position >= vertexes.size())
+            continue;
+        open_quests.next_vertexes.push_back(vertexes[position]);
+        open_quests.next_stops.push_back(oracle->stop_index(vertexes[position]));
+        open_quests.suffix_lengths.push_back(chain_suffix_lengths[chain_offsets[quest_id] + position]);
+        if (reachability->rank_count() > 1)
+            open_rank = std::min(open_rank, reachability->rank(vertexes[position]));
+    }
+    if (open_quests.generated_at.empty())
+        open_quests.generated_at.assign(oracle->stop_count(), 0);
+    const std::uint32_t expansion = ++open_quests.expansion;
+    const double* from_current = oracle->distances_from_stop(oracle->stop_index(state.current_index));
+    for (size_t i = 0; i < open_quests.next_vertexes.size(); ++i) {
+        const int next_stop = open_quests.next_vertexes[i];
+        auto& generated_at = open_quests.generated_at[open_quests.next_stops[i]];
+        if (generated_at == expansion || reachability->rank(next_stop) > open_rank)
+            continue;
+        generated_at = expansion;
+        const double distance = from_current[open_quests.next_stops[i]];
+        if (!std::isfinite(distance))
+            continue;
+        const double bound = max_chain_bound(
+            oracle->distances_from_stop(open_quests.next_stops[i]),
+            open_quests.next_stops.data(),
+            open_quests.suffix_lengths.data(),
+            open_quests.next_stops.size()
+        );
+        auto new_state = state;
+        new_state.current_index = next_stop;
+        new_state.length += distance;
+        new_state.estimate = new_state.length + bound;
+        emit_child(std::move(new_state), metrics, deferred_children);
+    }
+}
+
+bool QuestOptimizer::update_state(PathState& current_state, WorkerMetrics& metrics, OpenQuests& open_quests) {
     if (minimum_quest_count.load(std::memory_order::acquire) == 0) {
         minimum_quest_count.store(total_quest_count, std::memory_order::release);
     }
-    if (current_state.remaining_quest_count <=
-        std::max(minimum_quest_count.load(std::memory_order::acquire), 1u) * error_afford) {
-        cv_queue.notify_all();
-        for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
-            const auto& quest_line = graph_data.quest_lines[quest_id];
-            auto& position = current_state.quest_positions[quest_id];
-            if (position < quest_line.vertexes.size() && quest_line.vertexes[position] == current_state.current_index) {
-                ++position;
-                --current_state.remaining_quest_count;
-            }
-        }
-        if (current_state.remaining_quest_count == 0) {
-            {
-                const std::scoped_lock lock(queue_mutex);
-                if (auto& current_best_path = best_path_for_start[current_state.path.vertexes[0]];
-                    current_best_path.vertexes.empty() || current_best_path.length > current_state.path.length)
-                    current_best_path = current_state.path;
-                found_best_paths.fetch_add(1, std::memory_order::release);
-            }
-            minimum_quest_count.store(total_quest_count, std::memory_order::release);
-            local_found = true;
-        } else {
-            for (size_t quest_id = 0; quest_id < graph_data.quest_lines.size(); ++quest_id) {
-                const auto& quest_line = graph_data.quest_lines[quest_id];
-                const auto position = current_state.quest_positions[quest_id];
-                if (position >= quest_line.vertexes.size())
-                    continue;
-                auto new_state = current_state;
-                new_state.current_index = quest_line.vertexes[position];
-                new_state.path.length += 1;
-                const std::scoped_lock lock(queue_mutex);
-                queue.insert(std::move(new_state));
-            }
-        }
+    const auto minimum_quests = minimum_quest_count.load(std::memory_order::acquire);
+    if (expand_state(current_state, minimum_quests, metrics, open_quests, nullptr) != Expansion::complete)
+        return false;
+    record_complete_path(current_state);
+    minimum_quest_count.store(total_quest_count, std::memory_order::release);
+    return true;
+}
+
+void QuestOptimizer::finish_expansion(const PathState& state, const bool found) {
+    if (!found && found_best_paths.load(std::memory_order::acquire) < depth_of_search) {
+        const unsigned remaining = state.remaining_quest_count;
+        atomic_fetch_min(minimum_quest_count, remaining);
+    }
+    if (found_best_paths.load(std::memory_order::acquire) >= depth_of_search) {
+        stop_event.store(true, std::memory_order::release);
     }
-    return local_found;
 }
 
-void QuestOptimizer::optimize_cycle() {
-    bool local_found = false;
-    const bool use_fast_travel = graph_data.fast_travel;
+void QuestOptimizer::optimize_cycle(const unsigned worker) {
+    WorkerMetrics& metrics = search_metrics.worker(worker);
+    OpenQuests open_quests;
+    // start of the current run of empty pops, only read while `idle` is set
+    std::chrono::steady_clock::time_point idle_since;
+    bool idle = false;
     while (!stop_event.load(std::memory_order::acquire)) {
-        PathState current_state;
-        {
-            std::unique_lock lock(queue_mutex);
-            ++sleeping_threads;
-            cv_queue.wait(lock, [this] { return stop_event.load(std::memory_order::acquire) || !queue.empty(); });
-            if (sleeping_threads == num_threads && queue.empty()) {
+        auto popped_state = frontier.try_pop(&metrics);
+        if (!popped_state) {
+            if (!idle) {
+                idle_since = std::chrono::steady_clock::now();
+                idle = true;
+            }
+            if (frontier.exhausted()) {
                 stop_event.store(true, std::memory_order::release);
-                cv_queue.notify_all();
+                break;
             }
-            --sleeping_threads;
-            if (stop_event.load(std::memory_order::acquire)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (idle) {
+            metrics.add_time(WorkerMetrics::idle_ns, std::chrono::steady_clock::now() - idle_since);
+            idle = false;
+        }
+        PathState& current_state = *popped_state;
+        if (current_state.estimate >= incumbent_length->load(std::memory_order::relaxed)) {
+            metrics.add(WorkerMetrics::bound_prunes);
+            frontier.task_done();
+            continue;
+        }
+        if (dominance.dominated(current_state.current_index, current_state.quest_progress, current_state.length)) {
+            metrics.add(WorkerMetrics::dominated);
+            frontier.task_done();
+            continue;
+        }
+
+        const bool found = update_state(current_state, metrics, open_quests);
+        frontier.task_done();
+        finish_expansion(current_state, found);
+    }
+    if (idle)
+        metrics.add_time(WorkerMetrics::idle_ns, std::chrono::steady_clock::now() - idle_since);
+}
+
+// Synchronous rounds: worker 0 takes the best states off the frontier, every worker expands its fixed stride of the
+// batch into per-state child lists, and worker 0 merges the outcomes back in batch order. The frontier, the dominance
+// table and the incumbent are only touched by worker 0, so neither thread timing nor thread count changes the search.
+void QuestOptimizer::optimize_rounds() {
+    const unsigned workers = std::max(num_threads, 1u);
+    std::barrier sync(workers);
+    std::vector<PathState> batch;
+    std::vector<Expansion> outcomes;
+    std::vector<std::vector<PathState>> children(deterministic_batch_size);
+    unsigned round_minimum = 0;
+    bool done = false;
+    const auto wait = [&](WorkerMetrics& metrics) {
+        const auto begin = std::chrono::steady_clock::now();
+        sync.arrive_and_wait();
+        metrics.add_time(WorkerMetrics::idle_ns, std::chrono::steady_clock::now() - begin);
+    };
+    const auto expand_slice = [&](const unsigned worker, OpenQuests& open_quests) {
+        WorkerMetrics& metrics = search_metrics.worker(worker);
+        for (size_t i = worker; i < batch.size(); i += workers) {
+            outcomes[i] = expand_state(batch[i], round_minimum, metrics, open_quests, &children[i]);
+        }
+    };
+    const auto follow = [&](const unsigned worker) {
+        OpenQuests open_quests;
+        WorkerMetrics& metrics = search_metrics.worker(worker);
+        while (true) {
+            wait(metrics);
+            if (done)
                 return;
+            expand_slice(worker, open_quests);
+            wait(metrics);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < workers; ++i) {
+        threads.emplace_back(follow, i);
+    }
+
+    WorkerMetrics& metrics = search_metrics.worker(0);
+    OpenQuests open_quests;
+    while (true) {
+        batch.clear();
+        while (batch.size() < deterministic_batch_size && !stop_event.load(std::memory_order::acquire)) {
+            auto popped_state = frontier.try_pop(&metrics);
+            if (!popped_state)
+                break;
+            if (popped_state->estimate >= incumbent_length->load(std::memory_order::relaxed)) {
+                metrics.add(WorkerMetrics::bound_prunes);
+                frontier.task_done();
+                continue;
             }
-            if (queue.empty()) {
+            if (dominance.dominated(popped_state->current_index, popped_state->quest_progress, popped_state->length)) {
+                metrics.add(WorkerMetrics::dominated);
+                frontier.task_done();
                 continue;
             }
-            const auto it = queue.begin();
-            current_state = *it;
-            queue.erase(it);
+            batch.push_back(std::move(*popped_state));
         }
-
-        local_found = use_fast_travel ? update_state_fast_travel(current_state) : update_state(current_state);
-
-        if (!local_found && found_best_paths.load(std::memory_order::acquire) < depth_of_search) {
-            const unsigned remaining = current_state.remaining_quest_count;
-            atomic_fetch_min(minimum_quest_count, remaining);
+        if (batch.empty()) {
+            if (frontier.exhausted())
+                stop_event.store(true, std::memory_order::release);
+            done = true;
+            wait(metrics);
+            break;
         }
-        if (found_best_paths.load(std::memory_order::acquire) >= depth_of_search) {
-            stop_event.store(true, std::memory_order::release);
-            cv_queue.notify_all();
+        if (minimum_quest_count.load(std::memory_order::acquire) == 0)
+            minimum_quest_count.store(total_quest_count, std::memory_order::release);
+        round_minimum = minimum_quest_count.load(std::memory_order::acquire);
+        outcomes.resize(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            children[i].clear();
         }
+        wait(metrics);
+        expand_slice(0, open_quests);
+        wait(metrics);
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            // once the search is stopped the rest of the batch is only reported back
+            if (!stop_event.load(std::memory_order::acquire)) {
+                const bool found = outcomes[i] == Expansion::complete;
+                if (found) {
+                    record_complete_path(batch[i]);
+                    minimum_quest_count.store(total_quest_count, std::memory_order::release);
+                } else if (outcomes[i] == Expansion::expanded) {
+                    for (auto& child : children[i]) {
+                        push_state(std::move(child), &metrics);
+                    }
+                }
+                finish_expansion(batch[i], found);
+            }
+            frontier.task_done();
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
     }
 }
 
 void QuestOptimizer::optimize() {
-    const std::vector<size_t> initial_quest_positions(graph_data.quest_lines.size(), 0);
-    for (int i = 0; i < graph_data.vertex_count; ++i) {
-        queue.insert(PathState(i, Path{{}, 0.0}, initial_quest_positions, total_quest_count));
+    if (graph_data.fast_travel)
+        throw std::invalid_argument("QuestOptimizer searches walking maps, use FastTravelSolver for fast travel");
+    const auto deadline = std::chrono::steady_clock::now() + limits.time_budget;
+    if (total_quest_count == 0) {
+        // nothing to visit: the route is the start alone, or empty without one
+        best_path = Path{graph_data.start_index == -1 ? std::vector<int>{} : std::vector{graph_data.start_index}, 0.0};
+        proven_optimal = true;
+        return;
+    }
+    const auto initial_progress = progress_layout.initial();
+    if (deterministic)
+        frontier.make_deterministic();
+    if (!reachability)
+        reachability = std::make_shared<const StopReachability>(graph_data);
+    reachability->require_feasible();
+    if (!oracle) {
+        std::cout << "Building distance oracle" << std::endl;
+        oracle = std::make_shared<const DistanceOracle>(graph_data, num_threads);
+    }
+    build_chain_bounds();
+    if (!previous_route.empty())
+        record_previous_route_suffix();
+    const auto seeds = portfolio_seeds.empty() ? seed_vertices(graph_data, reachability.get()) : portfolio_seeds;
+    for (const int stop : seeds) {
+        const double start_length = graph_data.start_index == -1 ? 0.0 : oracle->distance(graph_data.start_index, stop);
+        if (std::isfinite(start_length))
+            push_state(make_state(stop, start_length, initial_progress));
     }
     auto threads = std::vector<std::thread>{};
     threads.reserve(num_threads);
@@ -223,50 +645,92 @@ void QuestOptimizer::optimize() {
             std::ref(found_best_paths),
             std::ref(minimum_quest_count),
             std::ref(stop_event),
-            std::ref(queue),
-            std::ref(queue_mutex),
+            std::cref(frontier),
             log_interval_seconds
         );
     }
-    for (unsigned i = 0; i < num_threads; ++i) {
-        threads.emplace_back(&QuestOptimizer::optimize_cycle, this);
+    std::thread watchdog_thread{};
+    if (limits.time_budget.count() > 0 || limits.max_rss_bytes > 0) {
+        watchdog_thread = std::thread(&QuestOptimizer::watch_limits, this, deadline);
+    }
+    std::thread metrics_thread{};
+    if (metrics_out != nullptr && metrics_interval_seconds > 0.0f) {
+        metrics_thread = std::thread(&QuestOptimizer::report_metrics_periodically, this);
+    }
+    if (deterministic) {
+        optimize_rounds();
+    } else {
+        for (unsigned i = 0; i < num_threads; ++i) {
+            threads.emplace_back(&QuestOptimizer::optimize_cycle, this, i);
+        }
+        for (unsigned i = 0; i < num_threads; ++i) {
+            threads[i].join();
+        }
     }
-    for (unsigned i = 0; i < num_threads; ++i) {
-        threads[i].join();
+    if (watchdog_thread.joinable() || metrics_thread.joinable()) {
+        { const std::scoped_lock lock(watchdog_mutex); }
+        watchdog_wakeup.notify_all();
     }
+    if (watchdog_thread.joinable())
+        watchdog_thread.join();
+    if (metrics_thread.joinable())
+        metrics_thread.join();
+    if (metrics_out != nullptr)
+        search_metrics.write_snapshot(
+            *metrics_out,
+            frontier.size(),
+            incumbent_length->load(std::memory_order::relaxed),
+            true
+        );
     if (std::abs(log_interval_seconds) >= std::numeric_limits<float>::epsilon()) {
         logger_thread.join();
     }
-    if (graph_data.start_index == -1) {
-        const auto it = std::ranges::min_element(best_path_for_start, [](const auto& a, const auto& b) {
-            if (!std::isfinite(a.second.length))
-                return false;
-            if (!std::isfinite(b.second.length))
-                return true;
-            return a.second.vertexes.size() < b.second.vertexes.size();
-        });
-        if (it != best_path_for_start.end() && std::isfinite(it->second.length)) {
-            best_path = it->second;
-        } else {
-            std::cerr << "[ERROR] No valid path found in best_path_for_start." << std::endl;
-        }
-    } else {
-        std::cout << "Dijkstra optimization" << std::endl;
-        const auto start_paths = dijkstra_from(graph_data.start_index);
-        best_path = Path({}, std::numeric_limits<double>::infinity());
-        for (const auto& [via_vertex, coverage_path] : best_path_for_start) {
-            auto it = start_paths.find(via_vertex);
-            if (it == start_paths.end())
-                continue;
-
-            const Path& to_via = it->second;
+    proven_optimal = !search_truncated.load(std::memory_order::acquire) && frontier.dropped_count() == 0 &&
+                     frontier.exhausted();
+    const bool found_route = std::ranges::any_of(best_path_for_start | std::views::values, [&](const Path& path) {
+        return !path.vertexes.empty() && std::isfinite(path.length);
+    });
+    if (!found_route && !proven_optimal && complete_best_state_greedily())
+        std::cout << "No route was completed within the limits, finished the best queued state greedily" << std::endl;
+    if (!proven_optimal)
+        refine_best_paths(deadline);
+    const auto it = std::ranges::min_element(best_path_for_start, [&](const auto& a, const auto& b) {
+        if (a.second.vertexes.empty() || !std::isfinite(a.second.length))
+            return false;
+        if (b.second.vertexes.empty() || !std::isfinite(b.second.length))
+            return true;
+        return a.second.length < b.second.length;
+    });
+    if (it != best_path_for_start.end() && !it->second.vertexes.empty() && std::isfinite(it->second.length)) {
+        best_path = complete_route(it->second);
+        if (proven_optimal && portfolio_seeds.empty())
+            std::cout << "Search space exhausted, path is optimal" << std::endl;
+    } else if (portfolio_seeds.empty()) {
+        std::cerr << "[ERROR] No valid path found in best_path_for_start." << std::endl;
+    }
+}
 
-            if (const double total_length = to_via.length + coverage_path.length; total_length < best_path.length) {
-                best_path = to_via;
-                best_path += coverage_path;
-            }
-        }
+std::vector<int> QuestOptimizer::seed_vertices(const GraphData& graph_data, const StopReachability* reachability) {
+    auto stops = DistanceOracle::quest_stops(graph_data);
+    std::ranges::sort(stops);
+    const auto [first, last] = std::ranges::unique(stops);
+    stops.erase(first, last);
+    if (reachability != nullptr) {
+        std::erase_if(stops, [&](const int stop) {
+            return reachability->rank(stop) != reachability->first_quest_rank();
+        });
     }
+    return stops;
+}
+
+void QuestOptimizer::join_portfolio(
+    std::atomic<double>& shared_incumbent,
+    std::vector<int> seeds,
+    std::shared_ptr<const StopReachability> reachability
+) {
+    incumbent_length = &shared_incumbent;
+    portfolio_seeds = std::move(seeds);
+    this->reachability = std::move(reachability);
 }
 
 Path QuestOptimizer::get_best_path() const { return best_path; }
@@ -274,6 +738,7 @@ Path QuestOptimizer::get_best_path() const { return best_path; }
 bool print_quests_on_path(
     const Path& path,
     const std::vector<QuestLine>& quest_lines,
+    const QuestStopIndex& stop_index,
     const std::vector<std::string>& vertex_names,
     const bool use_vertex_names,
     const bool use_quest_names
@@ -289,19 +754,16 @@ bool print_quests_on_path(
         else
             std::cout << vertex_index << ":";
 
-        for (size_t quest_id = 0; quest_id < quest_lines.size(); ++quest_id) {
-            const auto& quest_line = quest_lines[quest_id];
-            auto& position = quest_positions[quest_id];
-            if (position == quest_line.vertexes.size())
+        // stops of one quest line come in position order, so repeated stops at this vertex are taken in one visit
+        for (const auto& [quest_id, position] : stop_index.stops_at(vertex_index)) {
+            auto& quest_position = quest_positions[quest_id];
+            if (quest_position != static_cast<size_t>(position))
                 continue;
-            while (position < quest_line.vertexes.size() && quest_line.vertexes[position] == vertex_index) {
-                if (use_quest_names)
-                    std::cout << quest_line.name << ' ';
-                else
-                    std::cout << quest_id << ' ';
-                ++position;
-            }
-            if (position == quest_line.vertexes.size())
+            if (use_quest_names)
+                std::cout << quest_lines[quest_id].name << ' ';
+            else
+                std::cout << quest_id << ' ';
+            if (++quest_position == quest_lines[quest_id].vertexes.size())
                 ++completed_quests;
         }
         std::cout << std::endl;
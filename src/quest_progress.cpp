@@ -0,0 +1,100 @@
+#include <bit>
+
+#include "quest_progress.hpp"
+
+namespace {
+std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+std::uint64_t read_bits(const std::uint64_t* words, const size_t bit_offset, const size_t bit_width) {
+    if (bit_width == 0)
+        return 0;
+    const size_t word = bit_offset / 64;
+    const size_t shift = bit_offset % 64;
+    std::uint64_t value = words[word] >> shift;
+    if (shift + bit_width > 64)
+        value |= words[word + 1] << (64 - shift);
+    return value & ((std::uint64_t{1} << bit_width) - 1);
+}
+
+void write_bits(std::uint64_t* words, const size_t bit_offset, const size_t bit_width, const std::uint64_t value) {
+    if (bit_width == 0)
+        return;
+    const size_t word = bit_offset / 64;
+    const size_t shift = bit_offset % 64;
+    const std::uint64_t mask = (std::uint64_t{1} << bit_width) - 1;
+    words[word] = (words[word] & ~(mask << shift)) | (value << shift);
+    if (shift + bit_width > 64) {
+        const size_t high_shift = 64 - shift;
+        words[word + 1] = (words[word + 1] & ~(mask >> high_shift)) | (value >> high_shift);
+    }
+}
+} // namespace
+
+ProgressLayout::ProgressLayout(const std::vector<QuestLine>& quest_lines) {
+    std::uint64_t seed = 0x51ed270b27a3c4f1ULL;
+    std::uint32_t bit_offset = 0;
+    fields.reserve(quest_lines.size());
+    for (const auto& quest_line : quest_lines) {
+        const auto bit_width = static_cast<std::uint32_t>(std::bit_width(quest_line.vertexes.size()));
+        fields.push_back({bit_offset, bit_width, static_cast<std::uint32_t>(zobrist.size())});
+        bit_offset += bit_width;
+        for (size_t position = 0; position <= quest_line.vertexes.size(); ++position) {
+            zobrist.push_back(splitmix64(seed));
+        }
+    }
+    word_count = (bit_offset + 63) / 64;
+}
+
+QuestProgress ProgressLayout::initial() const {
+    QuestProgress progress(word_count);
+    for (const auto& field : fields) {
+        progress.hash ^= zobrist[field.zobrist_offset];
+    }
+    return progress;
+}
+
+size_t ProgressLayout::position(const QuestProgress& progress, const size_t quest_id) const {
+    const auto& field = fields[quest_id];
+    return read_bits(progress.words(), field.bit_offset, field.bit_width);
+}
+
+void ProgressLayout::advance(QuestProgress& progress, const size_t quest_id) const {
+    set_position(progress, quest_id, position(progress, quest_id) + 1);
+}
+
+void ProgressLayout::set_position(QuestProgress& progress, const size_t quest_id, const size_t position) const {
+    const auto& field = fields[quest_id];
+    const size_t old_position = read_bits(progress.words(), field.bit_offset, field.bit_width);
+    write_bits(progress.words(), field.bit_offset, field.bit_width, position);
+    progress.hash ^= zobrist[field.zobrist_offset + old_position] ^ zobrist[field.zobrist_offset + position];
+}
+
+std::uint64_t DominanceTable::hash_of(const int vertex, const QuestProgress& progress) {
+    return progress.hash ^ (static_cast<std::uint64_t>(static_cast<std::uint32_t>(vertex)) * 0x9e3779b97f4a7c15ULL);
+}
+
+bool DominanceTable::try_improve(const int vertex, const QuestProgress& progress, const double length) {
+    auto& shard = shards[hash_of(vertex, progress) % shard_count];
+    const std::scoped_lock lock(shard.mutex);
+    if (const auto it = shard.best_lengths.find(KeyView{vertex, progress}); it != shard.best_lengths.end()) {
+        if (length >= it->second)
+            return false;
+        it->second = length;
+        return true;
+    }
+    if (shard.best_lengths.size() < shard_capacity)
+        shard.best_lengths.emplace(Key{vertex, progress}, length);
+    return true;
+}
+
+bool DominanceTable::dominated(const int vertex, const QuestProgress& progress, const double length) {
+    auto& shard = shards[hash_of(vertex, progress) % shard_count];
+    const std::scoped_lock lock(shard.mutex);
+    const auto it = shard.best_lengths.find(KeyView{vertex, progress});
+    return it != shard.best_lengths.end() && it->second < length;
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "search_metrics.hpp"
+
+namespace {
+void write_counters(std::ostream& out, const MetricTotals& values) {
+    out << '{';
+    for (size_t counter = 0; counter < values.size(); ++counter) {
+        out << (counter > 0 ? "," : "") << '"' << WorkerMetrics::counter_names[counter] << "\":" << values[counter];
+    }
+    out << '}';
+}
+
+MetricTotals read_counters(const WorkerMetrics& slot) {
+    MetricTotals values{};
+    for (size_t counter = 0; counter < values.size(); ++counter) {
+        values[counter] = slot.get(static_cast<WorkerMetrics::Counter>(counter));
+    }
+    return values;
+}
+} // namespace
+
+SearchMetrics::SearchMetrics(const unsigned num_workers) : slots(std::max(num_workers, 1u)) {}
+
+MetricTotals SearchMetrics::totals() const {
+    MetricTotals total{};
+    for (const auto& slot : slots) {
+        const auto values = read_counters(slot);
+        for (size_t counter = 0; counter < total.size(); ++counter) {
+            total[counter] += values[counter];
+        }
+    }
+    return total;
+}
+
+void SearchMetrics::write_snapshot(
+    std::ostream& out,
+    const size_t queue_size,
+    const double best_length,
+    const bool final
+) const {
+    // one line is built first so snapshots never interleave with other writers of the stream
+    std::ostringstream line;
+    line.precision(10);
+    line << "{\"elapsed_ms\":"
+         << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+         << ",\"queue_size\":" << queue_size << ",\"best_length\":";
+    if (std::isfinite(best_length))
+        line << best_length;
+    else
+        line << "null";
+    line << ",\"final\":" << (final ? "true" : "false") << ",\"total\":";
+    write_counters(line, totals());
+    line << ",\"workers\":[";
+    for (size_t worker = 0; worker < slots.size(); ++worker) {
+        if (worker > 0)
+            line << ',';
+        write_counters(line, read_counters(slots[worker]));
+    }
+    line << "]}\n";
+    out << line.str() << std::flush;
+}
@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include "shortest_paths.hpp"
+
+ShortestPaths::ShortestPaths(const GraphData& graph_data)
+    : graph_data(graph_data),
+      labels(graph_data.vertex_count) {}
+
+void ShortestPaths::reset() {
+    for (const int vertex : touched) {
+        labels[vertex] = {};
+    }
+    touched.clear();
+    heap.clear();
+}
+
+std::vector<int> ShortestPaths::path_to(const int vertex) const {
+    std::vector<int> path;
+    if (!reached(vertex))
+        return path;
+    for (int current = vertex; current != -1; current = labels[current].pred) {
+        path.push_back(current);
+    }
+    std::ranges::reverse(path);
+    return path;
+}
+
+FastTravelStart::FastTravelStart(const GraphData& graph_data, const int start_vertex)
+    : start_vertex(start_vertex),
+      walks(graph_data) {
+    if (start_vertex != -1)
+        walks.run(start_vertex);
+}
+
+double FastTravelStart::cost(const int vertex) const {
+    if (start_vertex == -1)
+        return 0.0;
+    return std::min(walks.distance(vertex), 1.0);
+}
+
+std::vector<int> FastTravelStart::path_to(const int vertex) const {
+    if (start_vertex == -1)
+        return {vertex};
+    if (walks.distance(vertex) < 1.0)
+        return walks.path_to(vertex);
+    return {start_vertex, vertex};
+}
@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+#include "exact_solver.hpp"
+#include "portfolio_solver.hpp"
+#include "quest_optimizer_x.hpp"
+#include "solver_service.hpp"
+
+namespace {
+// Minimal reader for the flat request objects of the JSON-lines protocol.
+class JsonReader final {
+public:
+    explicit JsonReader(const std::string_view text) : text(text) {}
+
+    void expect(const char c) {
+        if (!consume(c))
+            throw std::invalid_argument(std::string("Expected '") + c + "' in request");
+    }
+
+    bool consume(const char c) {
+        skip_whitespace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool at_end() {
+        skip_whitespace();
+        return pos == text.size();
+    }
+
+    std::string read_string() {
+        expect('"');
+        std::string result;
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c == '\\') {
+                if (pos >= text.size())
+                    break;
+                switch (c = text[pos++]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u': throw std::invalid_argument("Unicode escapes are not supported in requests");
+                default: break;
+                }
+            }
+            result += c;
+        }
+        expect('"');
+        return result;
+    }
+
+    // Skips one value of any type and returns its JSON text.
+    std::string_view read_raw_value() {
+        skip_whitespace();
+        const size_t begin = pos;
+        if (pos < text.size() && text[pos] == '"') {
+            read_string();
+        } else if (consume('[')) {
+            if (!consume(']')) {
+                do {
+                    read_raw_value();
+                } while (consume(','));
+                expect(']');
+            }
+        } else {
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+                   !std::isspace(static_cast<unsigned char>(text[pos]))) {
+                ++pos;
+            }
+            if (pos == begin)
+                throw std::invalid_argument("Missing value in request");
+        }
+        return text.substr(begin, pos - begin);
+    }
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+
+    void skip_whitespace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+};
+
+template <typename T>
+T parse_number(const std::string_view raw, const std::string& key) {
+    T value{};
+    const auto [end, error] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    if (error != std::errc{} || end != raw.data() + raw.size())
+        throw std::invalid_argument("Field \"" + key + "\" must be a number");
+    return value;
+}
+
+bool parse_bool(const std::string_view raw, const std::string& key) {
+    if (raw == "true")
+        return true;
+    if (raw == "false")
+        return false;
+    throw std::invalid_argument("Field \"" + key + "\" must be a boolean");
+}
+
+std::vector<int> parse_int_array(const std::string_view raw, const std::string& key) {
+    JsonReader reader(raw);
+    std::vector<int> values;
+    reader.expect('[');
+    if (!reader.consume(']')) {
+        do {
+            values.push_back(parse_number<int>(reader.read_raw_value(), key));
+        } while (reader.consume(','));
+        reader.expect(']');
+    }
+    return values;
+}
+
+std::string json_string(const std::string_view value) {
+    constexpr char hex_digits[] = "0123456789abcdef";
+    std::string result = "\"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        } else if (c == '\n') {
+            result += "\\n";
+            continue;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += "\\u00";
+            result += hex_digits[c >> 4];
+            result += hex_digits[c & 0xf];
+            continue;
+        }
+        result += c;
+    }
+    return result + '"';
+}
+
+// The "id" of a request line as JSON to echo back, "null" when absent or malformed. It is read before anything else
+// is validated, so error responses can still carry it.
+std::string request_id(const std::string_view line) {
+    std::string id = "null";
+    try {
+        JsonReader reader(line);
+        reader.expect('{');
+        if (reader.consume('}'))
+            return id;
+        do {
+            const std::string key = reader.read_string();
+            reader.expect(':');
+            const auto raw = reader.read_raw_value();
+            if (key != "id")
+                continue;
+            double number;
+            if (raw.starts_with('"'))
+                id = json_string(JsonReader(raw).read_string());
+            else if (raw == "true" || raw == "false" || raw == "null" ||
+                     std::from_chars(raw.data(), raw.data() + raw.size(), number).ptr == raw.data() + raw.size())
+                id = raw;
+        } while (reader.consume(','));
+    } catch (const std::invalid_argument&) {}
+    return id;
+}
+
+// Fills `query` from one request line; the "id" is read by request_id().
+void parse_request(const std::string_view line, SolveQuery& query) {
+    JsonReader reader(line);
+    reader.expect('{');
+    if (!reader.consume('}')) {
+        do {
+            const std::string key = reader.read_string();
+            reader.expect(':');
+            const auto raw = reader.read_raw_value();
+            if (key == "id") {
+                continue;
+            } else if (key == "quest_lines") {
+                query.quest_lines = parse_int_array(raw, key);
+            } else if (key == "quest_positions") {
+                query.quest_positions = parse_int_array(raw, key);
+            } else if (key == "previous_path") {
+                query.previous_path = parse_int_array(raw, key);
+            } else if (key == "start") {
+                query.start_index = raw == "null" ? -1 : parse_number<int>(raw, key);
+            } else if (key == "num_threads") {
+                query.num_threads = parse_number<unsigned>(raw, key);
+            } else if (key == "max_queue_size") {
+                query.max_queue_size = parse_number<unsigned>(raw, key);
+            } else if (key == "error_afford") {
+                query.error_afford = parse_number<double>(raw, key);
+            } else if (key == "depth_of_search") {
+                query.depth_of_search = parse_number<unsigned>(raw, key);
+            } else if (key == "beam_width") {
+                query.beam_width = parse_number<unsigned>(raw, key);
+            } else if (key == "portfolio") {
+                query.portfolio = parse_bool(raw, key);
+            } else if (key == "deterministic") {
+                query.deterministic = parse_bool(raw, key);
+            } else if (key == "exact") {
+                query.exact = parse_bool(raw, key);
+            } else if (key == "time_limit_ms") {
+                query.limits.time_budget = std::chrono::milliseconds(parse_number<long long>(raw, key));
+            } else if (key == "max_memory_mb") {
+                query.limits.max_rss_bytes = parse_number<size_t>(raw, key) << 20;
+            } else if (key == "stream") {
+                query.stream = parse_bool(raw, key);
+            } else if (key == "exact_memory_mb") {
+                query.exact_memory_bytes = parse_number<size_t>(raw, key) << 20;
+            } else {
+                throw std::invalid_argument("Unknown field \"" + key + "\"");
+            }
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+    if (!reader.at_end())
+        throw std::invalid_argument("Trailing characters after request");
+}
+
+std::string json_number(const double value) {
+    if (!std::isfinite(value))
+        return "null";
+    char buffer[32];
+    const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, end);
+}
+
+std::string json_path(const Path& path) {
+    std::string result = "[";
+    for (size_t i = 0; i < path.vertexes.size(); ++i) {
+        if (i > 0)
+            result += ',';
+        result += std::to_string(path.vertexes[i]);
+    }
+    return result + ']';
+}
+
+double milliseconds_since(const std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+} // namespace
+
+SolverService::SolverService(GraphData graph_data, const unsigned num_threads)
+    : graph_data(std::move(graph_data)),
+      num_threads(std::max(num_threads, 1u)) {}
+
+std::shared_ptr<const DistanceOracle> SolverService::oracle_for(const int start_index) {
+    std::promise<std::shared_ptr<const DistanceOracle>> promise;
+    std::shared_future<std::shared_ptr<const DistanceOracle>> oracle;
+    std::uint64_t generation = 0;
+    {
+        const std::scoped_lock lock(oracle_mutex);
+        auto it = oracles.find(start_index);
+        if (it == oracles.end()) {
+            if (oracles.size() >= max_cached_oracles)
+                oracles.erase(std::ranges::min_element(oracles, {}, [](const auto& entry) {
+                    return entry.second.last_use;
+                }));
+            generation = ++oracle_clock;
+            it = oracles.emplace(start_index, CachedOracle{promise.get_future().share(), generation, 0}).first;
+        }
+        it->second.last_use = ++oracle_clock;
+        oracle = it->second.oracle;
+    }
+    if (generation == 0)
+        return oracle.get();
+
+    try {
+        auto stops = DistanceOracle::quest_stops(graph_data);
+        if (start_index != -1)
+            stops.push_back(start_index);
+        std::cout << "Building distance oracle for start " << start_index << std::endl;
+        promise.set_value(std::make_shared<const DistanceOracle>(graph_data, std::move(stops), num_threads));
+    } catch (...) {
+        // waiting queries fail with the same error, later ones build again
+        promise.set_exception(std::current_exception());
+        const std::scoped_lock lock(oracle_mutex);
+        if (const auto it = oracles.find(start_index); it != oracles.end() && it->second.generation == generation)
+            oracles.erase(it);
+    }
+    return oracle.get();
+}
+
+GraphData SolverService::query_graph(const SolveQuery& query) const {
+    GraphData view{
+        .graph = graph_data.graph,
+        .fast_travel = graph_data.fast_travel,
+        .weighted = graph_data.weighted,
+        .bidirectional = graph_data.bidirectional,
+        .vertex_count = graph_data.vertex_count,
+        .start_index = query.start_index.value_or(graph_data.start_index),
+        .vertex_names = {},
+        .quest_lines = {},
+        .stop_index = {},
+    };
+    if (view.start_index < -1 || view.start_index >= view.vertex_count)
+        throw std::invalid_argument("Start vertex is out of range");
+    if (query.quest_lines.empty()) {
+        view.quest_lines = graph_data.quest_lines;
+    }
+    for (const int quest_id : query.quest_lines) {
+        if (quest_id < 0 || quest_id >= static_cast<int>(graph_data.quest_lines.size()))
+            throw std::invalid_argument("Quest line " + std::to_string(quest_id) + " does not exist");
+        view.quest_lines.push_back(graph_data.quest_lines[quest_id]);
+    }
+    // a playthrough in progress is the same problem over the stops that are still ahead
+    if (!query.quest_positions.empty() && query.quest_positions.size() != view.quest_lines.size())
+        throw std::invalid_argument("quest_positions must have one entry per quest line");
+    for (size_t i = 0; i < query.quest_positions.size(); ++i) {
+        auto& vertexes = view.quest_lines[i].vertexes;
+        const int position = query.quest_positions[i];
+        if (position < 0 || position > static_cast<int>(vertexes.size()))
+            throw std::invalid_argument("Quest position is out of range");
+        vertexes.erase(vertexes.begin(), vertexes.begin() + position);
+    }
+    view.stop_index = QuestStopIndex::build(view.quest_lines, view.vertex_count);
+    return view;
+}
+
+SolveResult SolverService::solve(const SolveQuery& query, const ImprovementCallback& on_improvement) {
+    const auto begin = std::chrono::steady_clock::now();
+    const GraphData view = query_graph(query);
+    const unsigned query_threads = std::max(query.num_threads, 1u);
+    SolveResult result;
+    if (query.exact) {
+        // the fast travel DP never reads stop distances, so it does not build or cache an oracle
+        const auto oracle = view.fast_travel ? nullptr : oracle_for(view.start_index);
+        ExactSolver solver(view, oracle.get(), query_threads, query.exact_memory_bytes);
+        solver.set_limits(query.limits);
+        result.path = solver.solve();
+        result.proven_optimal = std::isfinite(result.path.length);
+        // an optimal route cannot be improved on, so previous_path is not needed here
+        if (on_improvement && result.proven_optimal)
+            on_improvement(result.path);
+    } else if (view.fast_travel) {
+        FastTravelSolver solver(view, query_threads, query.beam_width);
+        solver.set_limits(query.limits);
+        if (on_improvement)
+            solver.on_improvement(on_improvement);
+        if (!query.previous_path.empty())
+            solver.seed_incumbent(query.previous_path);
+        solver.optimize();
+        result.path = solver.get_best_path();
+        result.proven_optimal = solver.is_proven_optimal();
+    } else if (query.portfolio) {
+        PortfolioSolver solver(
+            view,
+            query_threads,
+            query.max_queue_size,
+            query.error_afford,
+            query.depth_of_search,
+            oracle_for(view.start_index)
+        );
+        solver.set_limits(query.limits);
+        solver.set_deterministic(query.deterministic);
+        if (on_improvement)
+            solver.on_improvement(on_improvement);
+        solver.optimize();
+        result.path = solver.get_best_path();
+        result.proven_optimal = solver.is_proven_optimal();
+    } else {
+        QuestOptimizer optimizer(
+            view,
+            query_threads,
+            query.max_queue_size,
+            query.error_afford,
+            query.depth_of_search,
+            0.0,
+            oracle_for(view.start_index)
+        );
+        optimizer.set_limits(query.limits);
+        optimizer.set_deterministic(query.deterministic);
+        if (on_improvement)
+            optimizer.on_improvement(on_improvement);
+        if (!query.previous_path.empty())
+            optimizer.seed_incumbent(query.previous_path);
+        optimizer.optimize();
+        result.path = optimizer.get_best_path();
+        result.proven_optimal = optimizer.is_proven_optimal();
+    }
+    result.elapsed_ms = milliseconds_since(begin);
+    return result;
+}
+
+void SolverService::serve(std::istream& in, std::ostream& out, const SolveQuery& defaults) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        const std::string id = request_id(line);
+        std::string response;
+        try {
+            SolveQuery query = defaults;
+            parse_request(line, query);
+            ImprovementCallback on_improvement;
+            if (query.stream) {
+                on_improvement = [&, begin = std::chrono::steady_clock::now()](const Path& path) {
+                    out << "{\"id\":" << id << ",\"improved\":true,\"length\":" << json_number(path.length)
+                        << ",\"elapsed_ms\":" << json_number(milliseconds_since(begin))
+                        << ",\"path\":" << json_path(path) << '}' << std::endl;
+                };
+            }
+            const auto result = solve(query, on_improvement);
+            response = "{\"id\":" + id + ",\"length\":" + json_number(result.path.length) +
+                       ",\"optimal\":" + (result.proven_optimal ? "true" : "false") +
+                       ",\"elapsed_ms\":" + json_number(result.elapsed_ms) + ",\"path\":" + json_path(result.path) +
+                       "}";
+        } catch (const std::exception& e) {
+            response = "{\"id\":" + id + ",\"error\":" + json_string(e.what()) + "}";
+        }
+        out << response << std::endl;
+    }
+}
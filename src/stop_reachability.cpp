@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "stop_reachability.hpp"
+
+namespace {
+// Iterative Tarjan. Components are numbered in topological order of the condensation: every edge between two
+// components leads from the lower number to the higher one.
+std::vector<int> strongly_connected_components(const CsrGraph& graph, const int vertex_count, int& component_count) {
+    struct Frame {
+        int vertex;
+        int edge;
+    };
+    std::vector<int> component(vertex_count, -1);
+    std::vector<int> index(vertex_count, -1);
+    std::vector<int> low(vertex_count);
+    std::vector<int> stack;
+    std::vector<Frame> calls;
+    int next_index = 0;
+    component_count = 0;
+    const auto discover = [&](const int vertex) {
+        index[vertex] = low[vertex] = next_index++;
+        stack.push_back(vertex);
+        calls.push_back({vertex, graph.edge_begin(vertex)});
+    };
+    for (int root = 0; root < vertex_count; ++root) {
+        if (index[root] != -1)
+            continue;
+        discover(root);
+        while (!calls.empty()) {
+            const int vertex = calls.back().vertex;
+            if (const int edge = calls.back().edge; edge < graph.edge_end(vertex)) {
+                ++calls.back().edge;
+                const int next = graph.targets[edge];
+                if (index[next] == -1)
+                    discover(next);
+                else if (component[next] == -1)
+                    low[vertex] = std::min(low[vertex], index[next]);
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty())
+                low[calls.back().vertex] = std::min(low[calls.back().vertex], low[vertex]);
+            if (low[vertex] != index[vertex])
+                continue;
+            int member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                component[member] = component_count;
+            } while (member != vertex);
+            ++component_count;
+        }
+    }
+    // Tarjan completes sink components first
+    for (int& id : component) {
+        id = component_count - 1 - id;
+    }
+    return component;
+}
+
+std::string quest_line_label(const QuestLine& quest_line) {
+    return quest_line.name.empty() ? std::to_string(quest_line.id) : quest_line.name;
+}
+} // namespace
+
+StopReachability::StopReachability(const GraphData& graph_data) {
+    int component_count = 0;
+    component = strongly_connected_components(graph_data.graph, graph_data.vertex_count, component_count);
+
+    // one representative stop per component that holds stops, in topological order
+    std::vector<std::pair<int, int>> stop_components;
+    for (const auto& quest_line : graph_data.quest_lines) {
+        for (const int stop : quest_line.vertexes) {
+            stop_components.emplace_back(component[stop], stop);
+        }
+    }
+    if (graph_data.start_index != -1)
+        stop_components.emplace_back(component[graph_data.start_index], graph_data.start_index);
+    std::ranges::sort(stop_components);
+    const auto [last, end] = std::ranges::unique(stop_components, {}, &std::pair<int, int>::first);
+    stop_components.erase(last, end);
+
+    component_rank.assign(component_count, -1);
+    ranks = static_cast<int>(stop_components.size());
+    for (int i = 0; i < ranks; ++i) {
+        component_rank[stop_components[i].first] = i;
+    }
+    first_rank = ranks;
+    for (const auto& quest_line : graph_data.quest_lines) {
+        for (const int stop : quest_line.vertexes) {
+            first_rank = std::min(first_rank, rank(stop));
+        }
+    }
+    // without quest stops the route is just the start
+    if (first_rank == ranks)
+        first_rank = 0;
+
+    if (graph_data.start_index != -1 && rank(graph_data.start_index) != 0) {
+        problem = "Start vertex " + std::to_string(graph_data.start_index) + " cannot reach quest stop " +
+                  std::to_string(stop_components.front().second);
+        return;
+    }
+    for (const auto& quest_line : graph_data.quest_lines) {
+        const auto& vertexes = quest_line.vertexes;
+        for (size_t i = 1; i < vertexes.size(); ++i) {
+            if (rank(vertexes[i - 1]) > rank(vertexes[i])) {
+                problem = "Quest line " + quest_line_label(quest_line) + " cannot be completed in order: vertex " +
+                          std::to_string(vertexes[i - 1]) + " cannot reach vertex " + std::to_string(vertexes[i]);
+                return;
+            }
+        }
+    }
+
+    // Consecutive stop components must reach each other. A search from one only needs the components up to the next,
+    // so all searches together scan the condensation about once.
+    std::vector<std::pair<int, int>> component_edges;
+    const auto& graph = graph_data.graph;
+    for (int from = 0; from < graph_data.vertex_count; ++from) {
+        for (int e = graph.edge_begin(from); e < graph.edge_end(from); ++e) {
+            if (const int to = graph.targets[e]; component[from] != component[to])
+                component_edges.emplace_back(component[from], component[to]);
+        }
+    }
+    std::ranges::sort(component_edges);
+    component_edges.erase(std::ranges::unique(component_edges).begin(), component_edges.end());
+    std::vector<int> edge_offsets(component_count + 1, 0);
+    for (const auto& [from, to] : component_edges) {
+        ++edge_offsets[from + 1];
+    }
+    std::partial_sum(edge_offsets.begin(), edge_offsets.end(), edge_offsets.begin());
+
+    std::vector<int> visited_by(component_count, -1);
+    std::vector<int> pending;
+    for (int i = 0; i + 1 < ranks; ++i) {
+        const int from = stop_components[i].first;
+        const int target = stop_components[i + 1].first;
+        bool reached = false;
+        pending.assign(1, from);
+        visited_by[from] = i;
+        while (!pending.empty() && !reached) {
+            const int current = pending.back();
+            pending.pop_back();
+            for (int e = edge_offsets[current]; e < edge_offsets[current + 1]; ++e) {
+                const int next = component_edges[e].second;
+                if (next > target || visited_by[next] == i)
+                    continue;
+                visited_by[next] = i;
+                reached = reached || next == target;
+                pending.push_back(next);
+            }
+        }
+        if (!reached) {
+            problem = "Quest stops " + std::to_string(stop_components[i].second) + " and " +
+                      std::to_string(stop_components[i + 1].second) + " cannot both be reached by one route";
+            return;
+        }
+    }
+}
+
+void StopReachability::require_feasible() const {
+    if (!feasible())
+        throw InfeasibleInstance(problem);
+}